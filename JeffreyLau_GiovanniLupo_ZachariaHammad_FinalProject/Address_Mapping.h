@@ -0,0 +1,184 @@
+#ifndef __ADDRESS_MAPPING_HH__
+#define __ADDRESS_MAPPING_HH__
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <math.h>
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h> // uint64_t
+
+typedef enum Addr_Field{CHANNEL, RANK, BANK_GROUP, BANK, ROW, COLUMN, NUM_ADDR_FIELDS}Addr_Field;
+
+static const char *addr_field_names[NUM_ADDR_FIELDS] = {"Ch", "Ra", "Bg", "Ba", "Ro", "Co"};
+
+// Where each level of the DRAM hierarchy sits in a physical address
+typedef struct Address_Mapping
+{
+    Addr_Field order[NUM_ADDR_FIELDS]; // Fields above the block offset, least significant first
+    unsigned num_fields;
+    unsigned bits[NUM_ADDR_FIELDS];
+    unsigned block_shift;
+
+    bool bank_groups_in_bank; // No Bg field: the Ba field carries the bank-group bits on top
+    bool bank_xor; // Permutation-based interleaving: XOR the bank bits with the low row bits
+
+    unsigned channels;
+    unsigned ranks;
+    unsigned bank_groups;
+    unsigned banks; // Per bank group
+}Address_Mapping;
+
+typedef struct Dram_Address
+{
+    unsigned channel;
+    unsigned rank;
+    unsigned bank_group;
+    unsigned bank;
+    uint64_t row;
+    uint64_t column;
+}Dram_Address;
+
+bool isPowerOfTwo(unsigned x)
+{
+    return x != 0 && (x & (x - 1)) == 0;
+}
+
+// Parse a mapping such as "RoBaRaCoCh", written from the most significant field down.
+// Fields that are one wide may be left out; Ro must come first since it takes the remaining bits.
+bool initAddressMapping(Address_Mapping *mapping, const char *str, unsigned block_size,
+                        unsigned channels, unsigned ranks, unsigned bank_groups, unsigned banks,
+                        unsigned blocks_per_row, bool bank_xor)
+{
+    if (!isPowerOfTwo(channels) || !isPowerOfTwo(ranks) || !isPowerOfTwo(bank_groups) ||
+        !isPowerOfTwo(banks) || !isPowerOfTwo(blocks_per_row))
+    {
+        printf("DRAM organization must be in powers of two\n");
+        return false;
+    }
+
+    mapping->block_shift = log2(block_size);
+    mapping->channels = channels;
+    mapping->ranks = ranks;
+    mapping->bank_groups = bank_groups;
+    mapping->banks = banks;
+    mapping->bank_xor = bank_xor;
+
+    mapping->bits[CHANNEL] = log2(channels);
+    mapping->bits[RANK] = log2(ranks);
+    mapping->bits[BANK_GROUP] = log2(bank_groups);
+    mapping->bits[BANK] = log2(banks);
+    mapping->bits[ROW] = 0; // Whatever is left
+    mapping->bits[COLUMN] = log2(blocks_per_row);
+
+    unsigned len = strlen(str);
+    bool seen[NUM_ADDR_FIELDS] = {false};
+    mapping->num_fields = 0;
+
+    if (len % 2 != 0 || len / 2 > NUM_ADDR_FIELDS)
+    {
+        printf("Bad address mapping %s\n", str);
+        return false;
+    }
+
+    // Store least significant first
+    for (int pos = len - 2; pos >= 0; pos -= 2)
+    {
+        int field = -1;
+        for (unsigned f = 0; f < NUM_ADDR_FIELDS; f++)
+        {
+            if (strncmp(&str[pos], addr_field_names[f], 2) == 0)
+            {
+                field = f;
+            }
+        }
+
+        if (field < 0 || seen[field])
+        {
+            printf("Bad address mapping %s\n", str);
+            return false;
+        }
+        seen[field] = true;
+        mapping->order[mapping->num_fields++] = (Addr_Field)field;
+    }
+
+    mapping->bank_groups_in_bank = !seen[BANK_GROUP];
+    if (mapping->bank_groups_in_bank)
+    {
+        mapping->bits[BANK] += mapping->bits[BANK_GROUP];
+        mapping->bits[BANK_GROUP] = 0;
+    }
+
+    if (!seen[ROW] || mapping->order[mapping->num_fields - 1] != ROW)
+    {
+        printf("Address mapping %s must start with Ro\n", str);
+        return false;
+    }
+
+    for (unsigned f = 0; f < NUM_ADDR_FIELDS; f++)
+    {
+        if (!seen[f] && mapping->bits[f] != 0)
+        {
+            printf("Address mapping %s leaves out %s\n", str, addr_field_names[f]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void decodeAddress(Address_Mapping *mapping, uint64_t addr, Dram_Address *dram_addr)
+{
+    uint64_t fields[NUM_ADDR_FIELDS] = {0};
+
+    addr >>= mapping->block_shift;
+    for (unsigned i = 0; i < mapping->num_fields; i++)
+    {
+        Addr_Field field = mapping->order[i];
+        if (field == ROW)
+        {
+            fields[ROW] = addr;
+            break;
+        }
+
+        fields[field] = addr & (((uint64_t)1 << mapping->bits[field]) - 1);
+        addr >>= mapping->bits[field];
+    }
+
+    if (mapping->bank_groups_in_bank)
+    {
+        fields[BANK_GROUP] = fields[BANK] >> (unsigned)log2(mapping->banks);
+        fields[BANK] &= mapping->banks - 1;
+    }
+
+    // Rows that collide in one bank are spread over the banks and groups instead
+    if (mapping->bank_xor)
+    {
+        fields[BANK] ^= fields[ROW] & (mapping->banks - 1);
+        fields[BANK_GROUP] ^= (fields[ROW] >> (unsigned)log2(mapping->banks)) & (mapping->bank_groups - 1);
+    }
+
+    dram_addr->channel = fields[CHANNEL];
+    dram_addr->rank = fields[RANK];
+    dram_addr->bank_group = fields[BANK_GROUP];
+    dram_addr->bank = fields[BANK];
+    dram_addr->row = fields[ROW];
+    dram_addr->column = fields[COLUMN];
+}
+
+unsigned totalBanks(Address_Mapping *mapping)
+{
+    return mapping->channels * mapping->ranks * mapping->bank_groups * mapping->banks;
+}
+
+// Banks are numbered channel by channel, rank by rank, group by group
+unsigned flatBankId(Address_Mapping *mapping, Dram_Address *dram_addr)
+{
+    return ((dram_addr->channel * mapping->ranks + dram_addr->rank) * mapping->bank_groups +
+            dram_addr->bank_group) * mapping->banks + dram_addr->bank;
+}
+
+#endif
@@ -6,16 +6,87 @@
 
 #include <stdbool.h>
 
+// Why a waiting request has not issued yet
+typedef enum Stall_Cause{STALL_BANK_BUSY, STALL_HELD_BACK, NUM_STALL_CAUSES}Stall_Cause;
+
+static const char *stall_cause_names[NUM_STALL_CAUSES] = {"bank busy", "held back"};
+
 typedef struct Bank
 {
     uint64_t cur_clk; // current memory clock
     uint64_t next_free; // the future memory clock that the bank is free
+
+    // Row buffer, only tracked under a DRAM timing model
+    bool row_open;
+    uint64_t open_row;
+    uint64_t act_ready; // Earliest next ACT (tRC, tRP)
+    uint64_t pre_ready; // Earliest next PRE (tRAS, tWR)
+
+    unsigned hit_streak; // FR-FCFS-Cap: row hits served ahead of an older request
+
+    uint64_t busy_until; // For bank-level parallelism
+    uint64_t busy_cycles;
+
+    // Waiting requests that found the bank busy, each counted once
+    uint64_t conflicts;
+    // Cycles spent waiting by the bank's requests, while it was busy or while the scheduler
+    // held them back on a free bank (FCFS order, the read/write turn); summed up to stall_until
+    uint64_t stall_cycles[NUM_STALL_CAUSES];
+    uint64_t stall_until;
 }Bank;
 
+#define FAW_ACTS 4 // ACTs allowed within tFAW
+
+// Timing state shared by the banks of a rank
+typedef struct Rank_State
+{
+    uint64_t recent_acts[FAW_ACTS]; // Ring of the latest ACT clocks, for tRRD and tFAW
+    unsigned num_acts;
+    uint64_t read_ready; // Earliest next read command after a write (tWTR)
+
+    uint64_t cmd_until; // End of the last burst, where the rank starts being idle
+    uint64_t next_refresh;
+    uint64_t refresh_count;
+    uint64_t powerdown_cycles;
+    uint64_t self_refresh_cycles;
+}Rank_State;
+
+// ... by the ranks of a channel, which share its data bus
+typedef struct Channel_State
+{
+    uint64_t bus_ready; // Earliest next column command (tCCD)
+    uint64_t write_ready; // Earliest next write command after a read (tRTW)
+    bool writing; // Direction of the last burst
+}Channel_State;
+
+// ... and by the banks of a bank group
+typedef struct Group_State
+{
+    uint64_t act_ready; // tRRD_L
+    uint64_t col_ready; // tCCD_L
+}Group_State;
+
 void initBank(Bank *bank)
 {
     bank->cur_clk = 0;
     bank->next_free = 0;
+
+    bank->row_open = false;
+    bank->open_row = 0;
+    bank->act_ready = 0;
+    bank->pre_ready = 0;
+
+    bank->hit_streak = 0;
+
+    bank->busy_until = 0;
+    bank->busy_cycles = 0;
+
+    bank->conflicts = 0;
+    for (unsigned i = 0; i < NUM_STALL_CAUSES; i++)
+    {
+        bank->stall_cycles[i] = 0;
+    }
+    bank->stall_until = 0;
 }
 
 #endif
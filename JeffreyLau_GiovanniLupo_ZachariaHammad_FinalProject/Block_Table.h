@@ -0,0 +1,110 @@
+#ifndef __BLOCK_TABLE_HH__
+#define __BLOCK_TABLE_HH__
+
+#include <assert.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h> // uint64_t
+
+#define EMPTY_BLOCK UINT64_MAX
+
+// Open-addressed count of queued requests per block, for at most max_blocks distinct blocks
+typedef struct Block_Entry
+{
+    uint64_t block;
+    unsigned count;
+}Block_Entry;
+
+typedef struct Block_Table
+{
+    Block_Entry *entries;
+    uint64_t mask; // Capacity - 1, a power of two at least twice max_blocks
+}Block_Table;
+
+Block_Table* initBlockTable(unsigned max_blocks)
+{
+    Block_Table *table = (Block_Table *)malloc(sizeof(Block_Table));
+
+    uint64_t capacity = 2;
+    while (capacity < 2 * (uint64_t)max_blocks)
+    {
+        capacity *= 2;
+    }
+    table->mask = capacity - 1;
+
+    table->entries = (Block_Entry *)malloc(capacity * sizeof(Block_Entry));
+    for (uint64_t i = 0; i < capacity; i++)
+    {
+        table->entries[i].block = EMPTY_BLOCK;
+        table->entries[i].count = 0;
+    }
+
+    return table;
+}
+
+// Where the probe for block starts (Fibonacci hashing)
+uint64_t blockHome(Block_Table *table, uint64_t block)
+{
+    return (block * 0x9E3779B97F4A7C15ull) >> 32 & table->mask;
+}
+
+// Slot holding block, or the empty slot where it would go
+uint64_t blockSlot(Block_Table *table, uint64_t block)
+{
+    uint64_t slot = blockHome(table, block);
+    while (table->entries[slot].block != EMPTY_BLOCK && table->entries[slot].block != block)
+    {
+        slot = (slot + 1) & table->mask;
+    }
+    return slot;
+}
+
+unsigned blockCount(Block_Table *table, uint64_t block)
+{
+    return table->entries[blockSlot(table, block)].count;
+}
+
+void addBlock(Block_Table *table, uint64_t block)
+{
+    Block_Entry *entry = &table->entries[blockSlot(table, block)];
+    entry->block = block;
+    entry->count++;
+}
+
+void removeBlock(Block_Table *table, uint64_t block)
+{
+    uint64_t slot = blockSlot(table, block);
+    assert(table->entries[slot].count > 0);
+    if (--table->entries[slot].count > 0)
+    {
+        return;
+    }
+
+    // Shift later entries of the probe run back over the hole, so lookups never stop early
+    uint64_t hole = slot;
+    for (uint64_t next = (hole + 1) & table->mask; table->entries[next].block != EMPTY_BLOCK;
+         next = (next + 1) & table->mask)
+    {
+        uint64_t home = blockHome(table, table->entries[next].block);
+        // Movable unless its home lies cyclically in (hole, next]
+        bool stays = hole <= next ? (home > hole && home <= next) : (home > hole || home <= next);
+        if (!stays)
+        {
+            table->entries[hole] = table->entries[next];
+            hole = next;
+        }
+    }
+    table->entries[hole].block = EMPTY_BLOCK;
+    table->entries[hole].count = 0;
+}
+
+void freeBlockTable(Block_Table *table)
+{
+    free(table->entries);
+    free(table);
+}
+
+#endif
@@ -0,0 +1,243 @@
+#ifndef __CONFIG_HH__
+#define __CONFIG_HH__
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Dram_Timing.h"
+#include "Dram_Power.h"
+
+typedef enum Scheduler_Type{FCFS, OOO, FR_FCFS, FR_FCFS_CAP, PAR_BS, BLISS, NUM_SCHEDULERS}Scheduler_Type;
+
+static const char *scheduler_names[NUM_SCHEDULERS] = {"fcfs", "ooo", "fr-fcfs", "fr-fcfs-cap", "par-bs", "bliss"};
+
+// Everything the optional config file can set
+typedef struct Config
+{
+    bool row_timing; // Otherwise the flat nclks_read/nclks_write model
+    Dram_Timing timing;
+    Dram_Power power;
+
+    // Organization, banks are per bank group
+    unsigned channels;
+    unsigned ranks;
+    unsigned bank_groups;
+    unsigned banks;
+    char address_mapping[32]; // Most significant field first, e.g. RoBaRaCoCh
+    unsigned bank_xor; // Non-zero XORs the bank bits with the low row bits
+
+    // Parallel mode: one controller per channel, spread over this many threads (0 keeps one shared controller)
+    unsigned threads;
+    uint64_t epoch; // Cycles between channel barriers
+
+    // Separate read and write queues; 0 keeps one shared waiting queue
+    unsigned write_queue_size;
+    unsigned write_high_watermark; // Queued writes that start a write drain
+    unsigned write_low_watermark; // ... and that end it
+
+    Scheduler_Type scheduler;
+    unsigned frfcfs_cap; // FR-FCFS-Cap: row hits that may bypass an older request
+    unsigned batch_cap; // PAR-BS: requests marked per core per bank
+    unsigned bliss_threshold; // BLISS: consecutive requests before a core is blacklisted
+    uint64_t bliss_clear_interval; // BLISS: clocks between blacklist resets
+}Config;
+
+// What the controller does without a config file
+void defaultConfig(Config *config)
+{
+    config->row_timing = false;
+    defaultDramTiming(&config->timing);
+    defaultDramPower(&config->power);
+
+    // One channel of 8 banks, interleaved on consecutive blocks
+    config->channels = 1;
+    config->ranks = 1;
+    config->bank_groups = 1;
+    config->banks = 8;
+    strcpy(config->address_mapping, "RoCoBa");
+    config->bank_xor = 0;
+
+    config->threads = 0;
+    config->epoch = 10000;
+
+    config->write_queue_size = 0;
+    config->write_high_watermark = 48;
+    config->write_low_watermark = 16;
+
+    config->scheduler = OOO;
+    config->frfcfs_cap = 4;
+    config->batch_cap = 5;
+    config->bliss_threshold = 4;
+    config->bliss_clear_interval = 10000;
+}
+
+// Read "key = value" lines; blank lines and lines starting with # are skipped.
+// A config file turns on the row-buffer timing model unless it says "timing = flat".
+Config *loadConfig(const char *config_file)
+{
+    FILE *fd = fopen(config_file, "r");
+    if (fd == NULL)
+    {
+        printf("Cannot open %s\n", config_file);
+        return NULL;
+    }
+
+    Config *config = (Config *)malloc(sizeof(Config));
+    defaultConfig(config);
+    config->row_timing = true;
+
+    Dram_Timing *timing = &config->timing;
+    struct { const char *key; uint64_t *value; } params[] = {
+        {"tRCD", &timing->tRCD}, {"tCL", &timing->tCL}, {"tRP", &timing->tRP},
+        {"tRAS", &timing->tRAS}, {"tRC", &timing->tRC}, {"tWR", &timing->tWR},
+        {"tWTR", &timing->tWTR}, {"tRTW", &timing->tRTW}, {"tRRD", &timing->tRRD},
+        {"tRRD_L", &timing->tRRD_L}, {"tFAW", &timing->tFAW}, {"tCCD", &timing->tCCD},
+        {"tCCD_L", &timing->tCCD_L},
+        {"tREFI", &timing->tREFI}, {"tRFC", &timing->tRFC}, {"tRFCsb", &timing->tRFCsb},
+        {"powerdown_threshold", &timing->powerdown_threshold},
+        {"self_refresh_threshold", &timing->self_refresh_threshold},
+        {"tXP", &timing->tXP}, {"tXS", &timing->tXS},
+        {"bliss_clear_interval", &config->bliss_clear_interval}, {"epoch", &config->epoch}};
+    unsigned num_params = sizeof(params) / sizeof(params[0]);
+
+    struct { const char *key; unsigned *value; } small_params[] = {
+        {"row_size", &timing->row_size}, {"bus_width", &timing->bus_width},
+        {"frfcfs_cap", &config->frfcfs_cap},
+        {"batch_cap", &config->batch_cap}, {"bliss_threshold", &config->bliss_threshold},
+        {"channels", &config->channels}, {"ranks", &config->ranks},
+        {"bank_groups", &config->bank_groups}, {"banks", &config->banks},
+        {"bank_xor", &config->bank_xor}, {"threads", &config->threads},
+        {"devices_per_rank", &config->power.devices_per_rank},
+        {"write_queue_size", &config->write_queue_size},
+        {"write_high_watermark", &config->write_high_watermark},
+        {"write_low_watermark", &config->write_low_watermark}};
+    unsigned num_small_params = sizeof(small_params) / sizeof(small_params[0]);
+
+    Dram_Power *power = &config->power;
+    struct { const char *key; double *value; } real_params[] = {
+        {"VDD", &power->VDD}, {"tCK", &power->tCK}, {"IDD0", &power->IDD0},
+        {"IDD2N", &power->IDD2N}, {"IDD2P", &power->IDD2P}, {"IDD3N", &power->IDD3N},
+        {"IDD3P", &power->IDD3P}, {"IDD4R", &power->IDD4R}, {"IDD4W", &power->IDD4W},
+        {"IDD5B", &power->IDD5B}, {"IDD6", &power->IDD6}};
+    unsigned num_real_params = sizeof(real_params) / sizeof(real_params[0]);
+
+    char *line = NULL;
+    size_t len = 0;
+    bool ok = true;
+
+    while (ok && getline(&line, &len, fd) != -1)
+    {
+        char delim[] = " =\t\r\n";
+
+        char *key = strtok(line, delim);
+        if (key == NULL || key[0] == '#')
+        {
+            continue;
+        }
+
+        char *value = strtok(NULL, delim);
+        if (value == NULL)
+        {
+            printf("Missing value for %s in %s\n", key, config_file);
+            ok = false;
+            break;
+        }
+
+        bool known = false;
+        for (unsigned i = 0; i < num_params; i++)
+        {
+            if (strcmp(key, params[i].key) == 0)
+            {
+                *params[i].value = strtoull(value, NULL, 10);
+                known = true;
+            }
+        }
+        for (unsigned i = 0; i < num_small_params; i++)
+        {
+            if (strcmp(key, small_params[i].key) == 0)
+            {
+                *small_params[i].value = (unsigned)strtoul(value, NULL, 10);
+                known = true;
+            }
+        }
+
+        for (unsigned i = 0; i < num_real_params; i++)
+        {
+            if (strcmp(key, real_params[i].key) == 0)
+            {
+                *real_params[i].value = strtod(value, NULL);
+                known = true;
+            }
+        }
+
+        if (strcmp(key, "page_policy") == 0)
+        {
+            known = strcmp(value, "open") == 0 || strcmp(value, "closed") == 0;
+            timing->page_policy = strcmp(value, "closed") == 0 ? CLOSED_PAGE : OPEN_PAGE;
+        }
+        else if (strcmp(key, "refresh") == 0)
+        {
+            known = strcmp(value, "none") == 0 || strcmp(value, "all_bank") == 0 || strcmp(value, "same_bank") == 0;
+            timing->refresh_mode = strcmp(value, "none") == 0 ? NO_REFRESH :
+                                   strcmp(value, "same_bank") == 0 ? SAME_BANK_REFRESH : ALL_BANK_REFRESH;
+        }
+        else if (strcmp(key, "timing") == 0)
+        {
+            known = strcmp(value, "row_buffer") == 0 || strcmp(value, "flat") == 0;
+            config->row_timing = strcmp(value, "flat") != 0;
+        }
+        else if (strcmp(key, "address_mapping") == 0)
+        {
+            known = strlen(value) < sizeof(config->address_mapping);
+            if (known)
+            {
+                strcpy(config->address_mapping, value);
+            }
+        }
+        else if (strcmp(key, "scheduler") == 0)
+        {
+            for (unsigned i = 0; i < NUM_SCHEDULERS; i++)
+            {
+                if (strcmp(value, scheduler_names[i]) == 0)
+                {
+                    config->scheduler = (Scheduler_Type)i;
+                    known = true;
+                }
+            }
+        }
+
+        if (!known)
+        {
+            printf("Unknown setting %s = %s in %s\n", key, value, config_file);
+            ok = false;
+        }
+    }
+
+    free(line);
+    fclose(fd);
+
+    if (ok && config->write_queue_size &&
+        (config->write_high_watermark > config->write_queue_size ||
+         config->write_low_watermark >= config->write_high_watermark))
+    {
+        printf("Write watermarks need low < high <= write_queue_size in %s\n", config_file);
+        ok = false;
+    }
+
+    if (ok && timing->bus_width == 0)
+    {
+        printf("bus_width must be non-zero in %s\n", config_file);
+        ok = false;
+    }
+
+    if (!ok)
+    {
+        free(config);
+        return NULL;
+    }
+    return config;
+}
+
+#endif
@@ -3,32 +3,69 @@
 
 #include "Bank.h"
 #include "Queue.h"
+#include "Event_Queue.h"
+#include "Latency_Histogram.h"
+#include "Block_Table.h"
+#include "Config.h"
+#include "Address_Mapping.h"
 
 // Bank
 extern void initBank(Bank *bank);
 
 // Queue operations
-extern Queue* initQueue();
-extern void pushToQueue(Queue *q, Request *req);
-extern void migrateToQueue(Queue *q, Node *_node);
+extern Node_Pool* initNodePool(unsigned capacity);
+extern Queue* initQueue(Node_Pool *pool);
+extern Node *firstNode(Queue *q);
+extern Node *nextNode(Queue *q, Node *node);
+extern Node *pushToQueue(Queue *q, Request *req);
+extern void migrateToQueue(Queue *src, Queue *dst, Node *node);
 extern void deleteNode(Queue *q, Node *node);
+extern Node *nodeAt(Queue *q, int idx);
+extern void initBankQueue(Bank_Queue *bq);
+extern void linkToBank(Node_Pool *pool, Bank_Queue *bq, Node *node);
+extern void unlinkFromBank(Node_Pool *pool, Bank_Queue *bq, Node *node);
+
+// Event operations
+extern Event_Queue* initEventQueue(unsigned capacity);
+extern void pushEvent(Event_Queue *eq, uint64_t clk);
+extern uint64_t earliestEvent(Event_Queue *eq);
+extern void popEvent(Event_Queue *eq);
+
+// Block table
+extern Block_Table* initBlockTable(unsigned max_blocks);
+extern unsigned blockCount(Block_Table *table, uint64_t block);
+extern void addBlock(Block_Table *table, uint64_t block);
+extern void removeBlock(Block_Table *table, uint64_t block);
+extern void freeBlockTable(Block_Table *table);
+
+// Latency histograms
+extern void recordLatency(Latency_Histogram *hist, uint64_t latency);
 
 // CONSTANTS
 static unsigned MAX_WAITING_QUEUE_SIZE = 64;
 static unsigned BLOCK_SIZE = 128; // cache block size
-static unsigned NUM_OF_BANKS = 8; // number of banks
 
+// Flat latencies, used when no DRAM timing config is given
 static unsigned nclks_read = 53;
 static unsigned nclks_write = 53;
 
-//#define FCFS
-#define OOO
+#define MAX_CORES 16 // For the thread-aware schedulers
+
+// Jump over memory cycles in which nothing can complete or issue; cycle counts are unchanged
+#define IDLE_SKIPPING
+
+// Request types that may issue in a tick while reads and writes are queued separately
+typedef enum Issue_Mode{ISSUE_ANY, ISSUE_READS, ISSUE_WRITES}Issue_Mode;
 
 // Controller definition
 typedef struct Controller
 {
     // The memory controller needs to maintain records of all bank's status
     Bank *bank_status;
+    unsigned num_banks; // Across all channels, ranks and bank groups
+
+    // Backs the nodes of both queues
+    Node_Pool *node_pool;
 
     // Current memory clock
     uint64_t cur_clk;
@@ -36,39 +73,197 @@ typedef struct Controller
     // A queue contains all the requests that are waiting to be issued.
     Queue *waiting_queue;
 
+    // With config->write_queue_size set, the waiting queue holds a read queue of MAX_WAITING_QUEUE_SIZE
+    // and a write queue of write_queue_size, kept in one arrival order
+    unsigned waiting_reads;
+    unsigned waiting_writes;
+    bool draining; // Writes go first until the low watermark once the high one is reached
+    Issue_Mode issue_mode;
+    uint64_t write_drains;
+    uint64_t forwarded_reads; // Served by a queued write to the same block
+    Block_Table *queued_writes; // Waiting writes per block, NULL with the shared queue
+
     // A queue contains all the requests that have already been issued but are waiting to complete.
     Queue *pending_queue;
 
+    // Clocks at which issued requests complete and free their banks
+    Event_Queue *events;
+
     /* For decoding */
-    unsigned bank_shift;
-    uint64_t bank_mask;
-    uint64_t conflicts[64];
-    unsigned conflict_count;
+    Address_Mapping mapping;
     unsigned bank_conflicts;
 
+    /* Row-buffer timing, NULL for the flat model */
+    Dram_Timing *timing;
+    Dram_Power *power;
+    Rank_State *rank_status;
+    Group_State *group_status;
+    Channel_State *channel_status;
+    uint64_t bursts; // Data bus bursts that move one block
+
+    uint64_t row_hits;
+    uint64_t row_misses; // Bank precharged
+    uint64_t row_conflicts; // Another row open
+    uint64_t turnarounds; // Bursts in the other direction than the last one on their bus
+
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t refreshes;
+
+    // Energy, pJ
+    double act_energy; // ACT and its PRE
+    double read_energy;
+    double write_energy;
+    double refresh_energy;
+    double background_energy; // Filled in by finishDramPower()
+
+    // Per bank and request type, indexed bank_id * 2 + req_type
+    Latency_Histogram *queueing_latency; // Arrival to begin_exe
+    Latency_Histogram *service_latency; // begin_exe to end_exe
+
+    // Bank-level parallelism: busy bank-cycles over cycles with any bank busy
+    uint64_t any_busy_until;
+    uint64_t any_busy_cycles;
+
+    /* Scheduling, chosen by the config */
+    Config *config;
+    Bank_Queue *bank_queues; // Waiting requests of each bank
+    Node **picked; // Requests the free banks issue in the current tick, in arrival order
+    unsigned num_picked;
+    int *arrived_banks; // Banks given unflagged requests since the last tick, to check for conflicts
+    unsigned num_arrived;
+    uint64_t arrivals;
+
+    // PAR-BS
+    unsigned marked; // Requests of the current batch still waiting
+    unsigned *batch_load; // Marked requests per core per bank while forming a batch
+    unsigned core_rank[MAX_CORES]; // Lower ranks go first within a batch
+    uint64_t batches;
+
+    // BLISS
+    int last_core; // Core served last, and how many times in a row
+    unsigned streak;
+    bool blacklisted[MAX_CORES];
+    uint64_t blacklist_epoch;
+
 }Controller;
 
-Controller *initController()
+// Between REFs to a rank, or between REFsb commands, which take the banks of every group in turn
+uint64_t refreshInterval(Controller *controller)
+{
+    Config *config = controller->config;
+    if (config->timing.refresh_mode == SAME_BANK_REFRESH)
+    {
+        return config->timing.tREFI / config->banks;
+    }
+    return config->timing.tREFI;
+}
+
+// num_channels is either all of them or, for a parallel-mode channel controller, just one
+Controller *initChannelController(Config *config, unsigned num_channels)
 {
     Controller *controller = (Controller *)malloc(sizeof(Controller));
-    controller->bank_status = (Bank *)malloc(NUM_OF_BANKS * sizeof(Bank));
-    controller->conflict_count = 0;
-    memset(controller->conflicts, 0, sizeof(controller->conflicts));
-    for (int i = 0; i < NUM_OF_BANKS; i++)
+    controller->config = config;
+    controller->timing = config->row_timing ? &config->timing : NULL;
+    controller->power = &config->power;
+
+    if (!initAddressMapping(&controller->mapping, config->address_mapping, BLOCK_SIZE,
+                            config->channels, config->ranks, config->bank_groups, config->banks,
+                            config->timing.row_size / BLOCK_SIZE, config->bank_xor != 0))
+    {
+        free(controller);
+        return NULL;
+    }
+    controller->mapping.channels = num_channels;
+    controller->num_banks = totalBanks(&controller->mapping);
+
+    controller->bank_status = (Bank *)malloc(controller->num_banks * sizeof(Bank));
+    for (int i = 0; i < controller->num_banks; i++)
     {
         initBank(&((controller->bank_status)[i]));
     }
     controller->cur_clk = 0;
     controller->bank_conflicts = 0;
-    controller->waiting_queue = initQueue();
-    controller->pending_queue = initQueue();
+    // Sized for a full waiting queue plus as many in flight; grows if ever exceeded
+    controller->node_pool = initNodePool(2 * MAX_WAITING_QUEUE_SIZE);
+    controller->waiting_queue = initQueue(controller->node_pool);
+    controller->pending_queue = initQueue(controller->node_pool);
+    controller->events = initEventQueue(2 * MAX_WAITING_QUEUE_SIZE);
+    controller->waiting_reads = 0;
+    controller->waiting_writes = 0;
+    controller->draining = false;
+    controller->issue_mode = ISSUE_ANY;
+    controller->write_drains = 0;
+    controller->forwarded_reads = 0;
+    controller->queued_writes = config->write_queue_size ? initBlockTable(config->write_queue_size) : NULL;
+
+    controller->rank_status = (Rank_State *)calloc(num_channels * config->ranks, sizeof(Rank_State));
+    controller->group_status = (Group_State *)calloc(controller->num_banks / config->banks, sizeof(Group_State));
+    controller->channel_status = (Channel_State *)calloc(num_channels, sizeof(Channel_State));
+    unsigned burst_bytes = BURST_LENGTH * config->timing.bus_width;
+    controller->bursts = (BLOCK_SIZE + burst_bytes - 1) / burst_bytes;
+    controller->row_hits = 0;
+    controller->row_misses = 0;
+    controller->row_conflicts = 0;
+    controller->turnarounds = 0;
+    controller->reads = 0;
+    controller->writes = 0;
+    controller->refreshes = 0;
+    controller->act_energy = 0;
+    controller->read_energy = 0;
+    controller->write_energy = 0;
+    controller->refresh_energy = 0;
+    controller->background_energy = 0;
+    for (unsigned i = 0; i < num_channels * config->ranks; i++)
+    {
+        (controller->rank_status)[i].next_refresh = refreshInterval(controller);
+    }
+    controller->queueing_latency = (Latency_Histogram *)calloc(2 * controller->num_banks, sizeof(Latency_Histogram));
+    controller->service_latency = (Latency_Histogram *)calloc(2 * controller->num_banks, sizeof(Latency_Histogram));
+    controller->any_busy_until = 0;
+    controller->any_busy_cycles = 0;
 
-    controller->bank_shift = log2(BLOCK_SIZE);
-    controller->bank_mask = (uint64_t)NUM_OF_BANKS - (uint64_t)1;
+    controller->bank_queues = (Bank_Queue *)malloc(controller->num_banks * sizeof(Bank_Queue));
+    for (int i = 0; i < controller->num_banks; i++)
+    {
+        initBankQueue(&(controller->bank_queues)[i]);
+    }
+    controller->picked = (Node **)calloc(controller->num_banks, sizeof(Node *));
+    controller->num_picked = 0;
+    controller->arrived_banks = (int *)malloc(controller->num_banks * sizeof(int));
+    controller->num_arrived = 0;
+    controller->arrivals = 0;
+
+    controller->marked = 0;
+    controller->batch_load = (unsigned *)calloc(MAX_CORES * controller->num_banks, sizeof(unsigned));
+    memset(controller->core_rank, 0, sizeof(controller->core_rank));
+    controller->batches = 0;
+
+    controller->last_core = -1;
+    controller->streak = 0;
+    memset(controller->blacklisted, 0, sizeof(controller->blacklisted));
+    controller->blacklist_epoch = 0;
 
     return controller;
 }
 
+Controller *initController(Config *config)
+{
+    return initChannelController(config, config->channels);
+}
+
+// Average number of banks busy while any bank is
+double bankLevelParallelism(Controller *controller)
+{
+    uint64_t bank_busy_cycles = 0;
+    for (int i = 0; i < controller->num_banks; i++)
+    {
+        bank_busy_cycles += (controller->bank_status)[i].busy_cycles;
+    }
+
+    return controller->any_busy_cycles ? (double)bank_busy_cycles / (double)controller->any_busy_cycles : 0.0;
+}
+
 unsigned ongoingPendingRequests(Controller *controller)
 {
     unsigned num_requests_left = controller->waiting_queue->size + 
@@ -77,77 +272,722 @@ unsigned ongoingPendingRequests(Controller *controller)
     return num_requests_left;
 }
 
+// Count a request the first time it finds its bank busy
+void handleBankConflict(Controller *controller, Node *node)
+{
+    if (!node->conflicted)
+    {
+        node->conflicted = true;
+        controller->bank_conflicts++;
+        (controller->bank_status)[node->bank_id].conflicts++;
+    }
+}
+
+// Flag the requests that joined the bank since it was last found busy, so each is visited once
+void flagBankConflicts(Controller *controller, int bank_id)
+{
+    Bank_Queue *bq = &(controller->bank_queues)[bank_id];
+    for (Node *node = nodeAt(controller->waiting_queue, bq->first_unflagged); node != NULL;
+         node = nodeAt(controller->waiting_queue, node->bank_next))
+    {
+        handleBankConflict(controller, node);
+    }
+    bq->first_unflagged = NIL_NODE;
+}
+
+// Charge the bank's waiting requests for the cycles up to clk. Called before a request joins or
+// leaves the bank, so the count and next_free held over the whole interval.
+void accountStalls(Controller *controller, int bank_id, uint64_t clk)
+{
+    Bank *bank = &(controller->bank_status)[bank_id];
+    uint64_t waiting = (controller->bank_queues)[bank_id].size;
+
+    if (clk > bank->stall_until)
+    {
+        uint64_t busy_end = bank->next_free < clk ? bank->next_free : clk;
+        uint64_t busy = busy_end > bank->stall_until ? busy_end - bank->stall_until : 0;
+
+        bank->stall_cycles[STALL_BANK_BUSY] += waiting * busy;
+        bank->stall_cycles[STALL_HELD_BACK] += waiting * (clk - bank->stall_until - busy);
+        bank->stall_until = clk;
+    }
+}
+
+// A read of a block that a queued write is about to store needs no DRAM access
+bool isForwardable(Controller *controller, Request *req)
+{
+    return controller->queued_writes != NULL && req->req_type == READ &&
+           blockCount(controller->queued_writes, req->memory_address / BLOCK_SIZE) > 0;
+}
+
+bool hasRoom(Controller *controller, Request *req)
+{
+    if (controller->config->write_queue_size == 0)
+    {
+        return controller->waiting_queue->size < MAX_WAITING_QUEUE_SIZE;
+    }
+
+    return req->req_type == READ ? controller->waiting_reads < MAX_WAITING_QUEUE_SIZE
+                                 : controller->waiting_writes < controller->config->write_queue_size;
+}
+
+// Whether send() would take req now
+bool acceptsRequest(Controller *controller, Request *req)
+{
+    return hasRoom(controller, req) || isForwardable(controller, req);
+}
+
 bool send(Controller *controller, Request *req)
 {
-    if (controller->waiting_queue->size == MAX_WAITING_QUEUE_SIZE)
+    if (isForwardable(controller, req))
+    {
+        controller->forwarded_reads++;
+        return true;
+    }
+
+    if (!hasRoom(controller, req))
     {
         return false;
     }
 
     // Decode the memory address
-    req->bank_id = ((req->memory_address) >> controller->bank_shift) & controller->bank_mask;
-    
+    Dram_Address dram_addr;
+    decodeAddress(&controller->mapping, req->memory_address, &dram_addr);
+    dram_addr.channel %= controller->mapping.channels; // A channel controller numbers only its own banks
+    req->bank_id = flatBankId(&controller->mapping, &dram_addr);
+    req->row_id = dram_addr.row;
+
     // Push to queue
-    pushToQueue(controller->waiting_queue, req);
+    Node *node = pushToQueue(controller->waiting_queue, req);
+    node->arrival = controller->arrivals++;
+    node->arrival_clk = controller->cur_clk + 1; // The tick that follows is the first to see it
+    if (req->req_type == READ)
+    {
+        controller->waiting_reads++;
+    }
+    else
+    {
+        controller->waiting_writes++;
+        if (controller->queued_writes != NULL)
+        {
+            addBlock(controller->queued_writes, req->memory_address / BLOCK_SIZE);
+        }
+    }
+
+    // A bank without unflagged requests gets checked for a conflict in the next tick
+    Bank_Queue *bq = &(controller->bank_queues)[req->bank_id];
+    if (bq->first_unflagged == NIL_NODE && controller->config->scheduler != FCFS)
+    {
+        (controller->arrived_banks)[controller->num_arrived++] = req->bank_id;
+    }
+    accountStalls(controller, req->bank_id, node->arrival_clk);
+    linkToBank(controller->node_pool, bq, node);
 
     return true;
 }
 
-void handleBankConflict(Controller *controller, Node *node)
+// Clock at which the next ACT may go out, given tRRD and tFAW
+uint64_t actReady(Controller *controller, Rank_State *rank, Group_State *group, uint64_t clk)
+{
+    Dram_Timing *timing = controller->timing;
+    unsigned n = rank->num_acts;
+
+    if (n > 0)
+    {
+        uint64_t last_act = rank->recent_acts[(n - 1) % FAW_ACTS];
+        clk = clk > last_act + timing->tRRD ? clk : last_act + timing->tRRD;
+    }
+    if (n >= FAW_ACTS)
+    {
+        uint64_t oldest_act = rank->recent_acts[n % FAW_ACTS];
+        clk = clk > oldest_act + timing->tFAW ? clk : oldest_act + timing->tFAW;
+    }
+    clk = clk > group->act_ready ? clk : group->act_ready;
+
+    return clk;
+}
+
+// Issue the refreshes of a rank that are due by clk
+void refreshRank(Controller *controller, unsigned rank_id, uint64_t clk)
+{
+    Dram_Timing *timing = controller->timing;
+    Address_Mapping *mapping = &controller->mapping;
+    Rank_State *rank = &(controller->rank_status)[rank_id];
+
+    if (timing->refresh_mode == NO_REFRESH)
+    {
+        return;
+    }
+
+    bool same_bank = timing->refresh_mode == SAME_BANK_REFRESH;
+    uint64_t tRFC = same_bank ? timing->tRFCsb : timing->tRFC;
+    unsigned banks_per_rank = mapping->bank_groups * mapping->banks;
+    Bank *rank_banks = &(controller->bank_status)[rank_id * banks_per_rank];
+
+    while (rank->next_refresh <= clk)
+    {
+        unsigned target = rank->refresh_count % mapping->banks;
+
+        // Every bank refreshed has to finish its burst and be precharged first
+        uint64_t start = rank->next_refresh;
+        for (unsigned i = 0; i < banks_per_rank; i++)
+        {
+            Bank *bank = &rank_banks[i];
+            if (same_bank && i % mapping->banks != target)
+            {
+                continue;
+            }
+
+            uint64_t ready = bank->row_open ? (bank->pre_ready > bank->next_free ? bank->pre_ready : bank->next_free) + timing->tRP
+                                            : (bank->act_ready > bank->next_free ? bank->act_ready : bank->next_free);
+            start = ready > start ? ready : start;
+        }
+
+        for (unsigned i = 0; i < banks_per_rank; i++)
+        {
+            Bank *bank = &rank_banks[i];
+            if (same_bank && i % mapping->banks != target)
+            {
+                continue;
+            }
+
+            bank->row_open = false;
+            if (start + tRFC > bank->act_ready)
+            {
+                bank->act_ready = start + tRFC;
+            }
+        }
+
+        controller->refreshes++;
+        controller->refresh_energy += refreshEnergy(controller->power, tRFC);
+
+        rank->next_refresh += refreshInterval(controller);
+        rank->refresh_count++;
+    }
+}
+
+// Account the low-power states the rank went through while idle up to clk, returning its exit latency
+uint64_t wakeRank(Controller *controller, unsigned rank_id, uint64_t clk)
 {
-    // Check if the conflict has already been counted
-    bool already_counted = false;
-    for (unsigned i = 0; i < controller->conflict_count; i++)
+    Dram_Timing *timing = controller->timing;
+    Rank_State *rank = &(controller->rank_status)[rank_id];
+    uint64_t pd_threshold = timing->powerdown_threshold;
+    uint64_t sr_threshold = timing->self_refresh_threshold;
+    uint64_t exit_latency = 0;
+
+    if (sr_threshold && clk > rank->cmd_until + sr_threshold)
     {
-        if (controller->conflicts[i] == node->mem_addr)
+        uint64_t sr_entry = rank->cmd_until + sr_threshold;
+        refreshRank(controller, rank_id, sr_entry);
+
+        rank->self_refresh_cycles += clk - sr_entry;
+        if (pd_threshold && pd_threshold < sr_threshold)
+        {
+            rank->powerdown_cycles += sr_threshold - pd_threshold;
+        }
+
+        // The devices refreshed themselves meanwhile
+        while (rank->next_refresh <= clk)
         {
-            already_counted = true;
-            break;
+            rank->next_refresh += refreshInterval(controller);
+            rank->refresh_count++;
         }
+        exit_latency = timing->tXS;
+    }
+    else if (pd_threshold && clk > rank->cmd_until + pd_threshold)
+    {
+        rank->powerdown_cycles += clk - (rank->cmd_until + pd_threshold);
+        exit_latency = timing->tXP;
     }
 
-    if (!already_counted)
+    refreshRank(controller, rank_id, clk);
+    if (clk > rank->cmd_until)
     {
-        controller->bank_conflicts++;
-        controller->conflicts[controller->conflict_count++] = node->mem_addr;
+        rank->cmd_until = clk;
+    }
+
+    return exit_latency;
+}
+
+// Close out every rank at the end of the run and charge the background energy.
+// Standby and power-down count as active when pages are left open, precharged otherwise.
+void finishDramPower(Controller *controller, uint64_t end_clk)
+{
+    Dram_Power *power = controller->power;
+    bool open_page = controller->timing->page_policy == OPEN_PAGE;
+    unsigned num_ranks = controller->mapping.channels * controller->mapping.ranks;
+
+    controller->background_energy = 0;
+    for (unsigned i = 0; i < num_ranks; i++)
+    {
+        Rank_State *rank = &(controller->rank_status)[i];
+        wakeRank(controller, i, end_clk);
+
+        uint64_t low_power = rank->powerdown_cycles + rank->self_refresh_cycles;
+        uint64_t standby = end_clk > low_power ? end_clk - low_power : 0;
+        controller->background_energy += backgroundEnergy(power, open_page ? power->IDD3N : power->IDD2N, standby) +
+                                         backgroundEnergy(power, open_page ? power->IDD3P : power->IDD2P, rank->powerdown_cycles) +
+                                         backgroundEnergy(power, power->IDD6, rank->self_refresh_cycles);
     }
 }
 
-void removeBankConflict(Controller *controller, Node *node)
+// Place the PRE/ACT/column commands of node, setting when its data is done and when the bank frees up
+void scheduleDramCommands(Controller *controller, Bank *bank, Node *node)
 {
-    // Remove the request from the conflicted_requests list if it was there
-    for (unsigned i = 0; i < controller->conflict_count; i++)
+    Dram_Timing *timing = controller->timing;
+    Address_Mapping *mapping = &controller->mapping;
+    unsigned group_id = node->bank_id / mapping->banks;
+    unsigned rank_id = group_id / mapping->bank_groups;
+    unsigned channel_id = rank_id / mapping->ranks;
+
+    Group_State *group = &(controller->group_status)[group_id];
+    Rank_State *rank = &(controller->rank_status)[rank_id];
+    Channel_State *channel = &(controller->channel_status)[channel_id];
+
+    // Wake the rank and catch up on its refreshes before looking at the row buffer
+    uint64_t ready_clk = controller->cur_clk + wakeRank(controller, rank_id, controller->cur_clk);
+    uint64_t col_clk = ready_clk;
+
+    if (bank->row_open && bank->open_row == node->row_id)
     {
-        if (controller->conflicts[i] == node->mem_addr)
+        controller->row_hits++;
+    }
+    else
+    {
+        uint64_t act_clk = ready_clk;
+        if (bank->row_open)
         {
-            // Shift the remaining elements
-            for (unsigned j = i; j < controller->conflict_count - 1; j++)
-            {
-                controller->conflicts[j] = controller->conflicts[j + 1];
-            }
-            controller->conflict_count--;
-            break;
+            controller->row_conflicts++;
+
+            uint64_t pre_clk = act_clk > bank->pre_ready ? act_clk : bank->pre_ready;
+            act_clk = pre_clk + timing->tRP;
+        }
+        else
+        {
+            controller->row_misses++;
+        }
+
+        act_clk = act_clk > bank->act_ready ? act_clk : bank->act_ready;
+        act_clk = actReady(controller, rank, group, act_clk);
+        rank->recent_acts[rank->num_acts++ % FAW_ACTS] = act_clk;
+        group->act_ready = act_clk + timing->tRRD_L;
+        controller->act_energy += actEnergy(controller->power, timing);
+
+        bank->row_open = true;
+        bank->open_row = node->row_id;
+        bank->act_ready = act_clk + timing->tRC;
+        bank->pre_ready = act_clk + timing->tRAS;
+
+        col_clk = act_clk + timing->tRCD;
+    }
+
+    // Column commands share the channel's data bus, and are spaced further within a bank group
+    col_clk = col_clk > channel->bus_ready ? col_clk : channel->bus_ready;
+    col_clk = col_clk > group->col_ready ? col_clk : group->col_ready;
+    if (node->req_type == READ)
+    {
+        col_clk = col_clk > rank->read_ready ? col_clk : rank->read_ready;
+    }
+    else
+    {
+        col_clk = col_clk > channel->write_ready ? col_clk : channel->write_ready;
+    }
+    // The block goes out in back-to-back bursts, one column command each
+    uint64_t last_col_clk = col_clk + (controller->bursts - 1) * timing->tCCD;
+    channel->bus_ready = last_col_clk + timing->tCCD;
+    if (channel->writing != (node->req_type == WRITE))
+    {
+        controller->turnarounds++;
+        channel->writing = node->req_type == WRITE;
+    }
+    group->col_ready = last_col_clk + timing->tCCD_L;
+
+    uint64_t data_end = last_col_clk + timing->tCL + timing->tCCD;
+    rank->cmd_until = data_end > rank->cmd_until ? data_end : rank->cmd_until;
+    if (node->req_type == READ)
+    {
+        channel->write_ready = last_col_clk + timing->tRTW;
+        controller->reads++;
+        controller->read_energy += controller->bursts * readEnergy(controller->power, timing);
+    }
+    else
+    {
+        controller->writes++;
+        controller->write_energy += controller->bursts * writeEnergy(controller->power, timing);
+    }
+
+    if (node->req_type == WRITE)
+    {
+        rank->read_ready = data_end + timing->tWTR;
+        if (data_end + timing->tWR > bank->pre_ready)
+        {
+            bank->pre_ready = data_end + timing->tWR;
+        }
+    }
+
+    if (timing->page_policy == CLOSED_PAGE)
+    {
+        // Auto-precharge as soon as the bank allows it
+        uint64_t pre_clk = bank->pre_ready > last_col_clk + timing->tCCD ? bank->pre_ready : last_col_clk + timing->tCCD;
+        if (pre_clk + timing->tRP > bank->act_ready)
+        {
+            bank->act_ready = pre_clk + timing->tRP;
         }
+        bank->row_open = false;
     }
+
+    node->end_exe = data_end;
+    // The bank takes its next command once the last burst is on the bus
+    bank->next_free = last_col_clk + timing->tCCD;
 }
 
+void issueRequest(Controller *controller, Node *node)
+{
+    Bank *bank = &(controller->bank_status)[node->bank_id];
+    node->begin_exe = controller->cur_clk;
+
+    if (controller->timing == NULL)
+    {
+        if (node->req_type == READ)
+        {
+            node->end_exe = node->begin_exe + (uint64_t)nclks_read;
+        }
+        else if (node->req_type == WRITE)
+        {
+            node->end_exe = node->begin_exe + (uint64_t)nclks_write;
+        }
+        // The target bank is no longer free until this request completes.
+        bank->next_free = node->end_exe;
+    }
+    else
+    {
+        scheduleDramCommands(controller, bank, node);
+        pushEvent(controller->events, bank->next_free);
+    }
+
+    // Intervals arrive in order of begin_exe, so a running end is enough to merge them
+    uint64_t from = node->begin_exe > bank->busy_until ? node->begin_exe : bank->busy_until;
+    if (node->end_exe > from)
+    {
+        bank->busy_cycles += node->end_exe - from;
+        bank->busy_until = node->end_exe;
+    }
+    from = node->begin_exe > controller->any_busy_until ? node->begin_exe : controller->any_busy_until;
+    if (node->end_exe > from)
+    {
+        controller->any_busy_cycles += node->end_exe - from;
+        controller->any_busy_until = node->end_exe;
+    }
+
+    pushEvent(controller->events, node->end_exe);
+
+    unsigned slot = 2 * node->bank_id + node->req_type;
+    recordLatency(&(controller->queueing_latency)[slot], node->begin_exe - node->arrival_clk);
+    recordLatency(&(controller->service_latency)[slot], node->end_exe - node->begin_exe);
+}
+
+// Issue node and move it from the waiting to the pending queue
+void dispatchRequest(Controller *controller, Node *node)
+{
+    accountStalls(controller, node->bank_id, controller->cur_clk);
+    issueRequest(controller, node);
+
+    if (node->marked)
+    {
+        controller->marked--;
+    }
+
+    if (node->req_type == READ)
+    {
+        controller->waiting_reads--;
+    }
+    else
+    {
+        controller->waiting_writes--;
+        if (controller->queued_writes != NULL)
+        {
+            removeBlock(controller->queued_writes, node->mem_addr / BLOCK_SIZE);
+        }
+    }
+
+    // BLISS: a core served too many times in a row is blacklisted
+    if (node->core_id == controller->last_core)
+    {
+        if (++controller->streak >= controller->config->bliss_threshold)
+        {
+            controller->blacklisted[node->core_id] = true;
+        }
+    }
+    else
+    {
+        controller->last_core = node->core_id;
+        controller->streak = 1;
+    }
+
+    unlinkFromBank(controller->node_pool, &(controller->bank_queues)[node->bank_id], node);
+    migrateToQueue(controller->waiting_queue, controller->pending_queue, node);
+}
+
+// Reads go first unless the write queue is draining or no read waits
+Issue_Mode issueMode(Controller *controller)
+{
+    Config *config = controller->config;
+    if (config->write_queue_size == 0)
+    {
+        return ISSUE_ANY;
+    }
+
+    if (!controller->draining && controller->waiting_writes >= config->write_high_watermark)
+    {
+        controller->draining = true;
+        controller->write_drains++;
+    }
+    else if (controller->draining && controller->waiting_writes <= config->write_low_watermark)
+    {
+        controller->draining = false;
+    }
+
+    return controller->draining || controller->waiting_reads == 0 ? ISSUE_WRITES : ISSUE_READS;
+}
+
+bool mayIssue(Controller *controller, Node *node)
+{
+    return controller->issue_mode == ISSUE_ANY ||
+           (controller->issue_mode == ISSUE_WRITES) == (node->req_type == WRITE);
+}
+
+// FCFS: the oldest request that may issue
+Node *fcfsHead(Controller *controller)
+{
+    Node *node = firstNode(controller->waiting_queue);
+    while (node != NULL && !mayIssue(controller, node))
+    {
+        node = nextNode(controller->waiting_queue, node);
+    }
+    return node;
+}
+
+bool isRowHit(Controller *controller, Node *node)
+{
+    Bank *bank = &(controller->bank_status)[node->bank_id];
+    return controller->timing != NULL && bank->row_open && bank->open_row == node->row_id;
+}
+
+// PAR-BS: mark up to batch_cap of the oldest requests per core per bank, then rank cores
+// shortest job first by their heaviest bank load
+void formBatch(Controller *controller)
+{
+    unsigned *load = controller->batch_load;
+    memset(load, 0, MAX_CORES * controller->num_banks * sizeof(unsigned));
+
+    for (Node *node = firstNode(controller->waiting_queue); node != NULL;
+         node = nextNode(controller->waiting_queue, node))
+    {
+        unsigned *count = &load[node->core_id * controller->num_banks + node->bank_id];
+        if (*count < controller->config->batch_cap)
+        {
+            (*count)++;
+            node->marked = true;
+            controller->marked++;
+        }
+    }
+
+    unsigned max_load[MAX_CORES];
+    unsigned total_load[MAX_CORES];
+    for (unsigned c = 0; c < MAX_CORES; c++)
+    {
+        max_load[c] = 0;
+        total_load[c] = 0;
+        for (unsigned b = 0; b < controller->num_banks; b++)
+        {
+            unsigned count = load[c * controller->num_banks + b];
+            max_load[c] = count > max_load[c] ? count : max_load[c];
+            total_load[c] += count;
+        }
+    }
+
+    for (unsigned c = 0; c < MAX_CORES; c++)
+    {
+        controller->core_rank[c] = 0;
+        for (unsigned o = 0; o < MAX_CORES; o++)
+        {
+            bool lighter = max_load[o] < max_load[c] ||
+                           (max_load[o] == max_load[c] && total_load[o] < total_load[c]) ||
+                           (max_load[o] == max_load[c] && total_load[o] == total_load[c] && o < c);
+            controller->core_rank[c] += lighter;
+        }
+    }
+
+    controller->batches++;
+}
+
+// Lower keys issue first; ties go to the older request
+uint64_t schedulingKey(Controller *controller, Node *node)
+{
+    uint64_t row_miss = !isRowHit(controller, node);
+
+    switch (controller->config->scheduler)
+    {
+        case FR_FCFS:
+        case FR_FCFS_CAP:
+            return row_miss;
+        case PAR_BS:
+            return ((uint64_t)!node->marked << 40) | (row_miss << 32) | controller->core_rank[node->core_id];
+        case BLISS:
+            return ((uint64_t)controller->blacklisted[node->core_id] << 1) | row_miss;
+        default:
+            return 0;
+    }
+}
+
+// The request a free bank issues, found among that bank's waiting requests only; NULL if none may issue
+Node *pickFromBank(Controller *controller, int bank_id)
+{
+    Bank_Queue *bq = &(controller->bank_queues)[bank_id];
+    Bank *bank = &(controller->bank_status)[bank_id];
+    Node *oldest = nodeAt(controller->waiting_queue, bq->first);
+    while (oldest != NULL && !mayIssue(controller, oldest))
+    {
+        oldest = nodeAt(controller->waiting_queue, oldest->bank_next);
+    }
+
+    if (oldest == NULL)
+    {
+        return NULL;
+    }
+
+    if (controller->config->scheduler == OOO ||
+        (controller->config->scheduler == FR_FCFS_CAP && bank->hit_streak >= controller->config->frfcfs_cap))
+    {
+        bank->hit_streak = 0;
+        return oldest;
+    }
+
+    Node *best = oldest;
+    uint64_t best_key = schedulingKey(controller, oldest);
+    for (Node *node = nodeAt(controller->waiting_queue, oldest->bank_next); node != NULL && best_key != 0;
+         node = nodeAt(controller->waiting_queue, node->bank_next))
+    {
+        if (!mayIssue(controller, node))
+        {
+            continue;
+        }
+
+        uint64_t key = schedulingKey(controller, node);
+        if (key < best_key)
+        {
+            best = node;
+            best_key = key;
+        }
+    }
+
+    bank->hit_streak = best == oldest ? 0 : bank->hit_streak + 1;
+    return best;
+}
+
+void scheduleRequests(Controller *controller)
+{
+    if (controller->config->scheduler == FCFS)
+    {
+        // Implementation One - FCFS
+        Node *first = fcfsHead(controller);
+        if (first == NULL)
+        {
+            return;
+        }
+        int target_bank_id = first->bank_id;
+
+        if ((controller->bank_status)[target_bank_id].next_free <= controller->cur_clk)
+        {
+            dispatchRequest(controller, first);
+        } else{
+            handleBankConflict(controller,first);
+        }
+        return;
+    }
+
+    if (controller->config->scheduler == PAR_BS && controller->marked == 0)
+    {
+        formBatch(controller);
+    }
+
+    // Epochs keep the resets independent of which cycles were skipped
+    uint64_t epoch = controller->cur_clk / controller->config->bliss_clear_interval;
+    if (controller->config->scheduler == BLISS && epoch != controller->blacklist_epoch)
+    {
+        memset(controller->blacklisted, 0, sizeof(controller->blacklisted));
+        controller->blacklist_epoch = epoch;
+    }
+
+    // Every free bank picks one of its own requests, kept sorted by arrival
+    controller->num_picked = 0;
+    for (int i = 0; i < controller->num_banks; i++)
+    {
+        if ((controller->bank_status)[i].next_free > controller->cur_clk || (controller->bank_queues)[i].size == 0)
+        {
+            continue;
+        }
+
+        Node *pick = pickFromBank(controller, i);
+        if (pick == NULL)
+        {
+            continue;
+        }
+
+        unsigned j = controller->num_picked++;
+        while (j > 0 && (controller->picked)[j - 1]->arrival > pick->arrival)
+        {
+            (controller->picked)[j] = (controller->picked)[j - 1];
+            j--;
+        }
+        (controller->picked)[j] = pick;
+    }
+
+    // Issue the picks in arrival order, the order in which they share the rank and bus timing
+    for (unsigned i = 0; i < controller->num_picked; i++)
+    {
+        dispatchRequest(controller, (controller->picked)[i]);
+    }
+
+    // Everything left behind on a busy bank counts as a conflict. A bank only turns busy by issuing,
+    // so only the banks that just issued and those that just received requests need a look.
+    for (unsigned i = 0; i < controller->num_picked; i++)
+    {
+        flagBankConflicts(controller, (controller->picked)[i]->bank_id);
+    }
+    for (unsigned i = 0; i < controller->num_arrived; i++)
+    {
+        int bank_id = (controller->arrived_banks)[i];
+        if ((controller->bank_status)[bank_id].next_free > controller->cur_clk)
+        {
+            flagBankConflicts(controller, bank_id);
+        }
+    }
+    controller->num_arrived = 0;
+}
 
 void tick(Controller *controller)
 {
     // Step one, update system stats
     ++(controller->cur_clk);
     // printf("Clk: ""%"PRIu64"\n", controller->cur_clk);
-    for (int i = 0; i < NUM_OF_BANKS; i++)
+    for (int i = 0; i < controller->num_banks; i++)
     {
         ++(controller->bank_status)[i].cur_clk;
         // printf("%"PRIu64"\n", (controller->bank_status)[i].cur_clk);
     }
     // printf("\n");
 
+    // Drop the events already passed, so the heap holds only in-flight work
+    while (controller->events->size && earliestEvent(controller->events) <= controller->cur_clk)
+    {
+        popEvent(controller->events);
+    }
+
     // Step two, serve pending requests
     if (controller->pending_queue->size)
     {
-        Node *first = controller->pending_queue->first;
+        Node *first = firstNode(controller->pending_queue);
         if (first->end_exe <= controller->cur_clk)
         {
             /*
@@ -162,68 +1002,103 @@ void tick(Controller *controller)
     }
 
     // Step three, find a request to schedule
+    controller->issue_mode = issueMode(controller);
     if (controller->waiting_queue->size)
     {
-        #ifdef FCFS
-        // Implementation One - FCFS
-        Node *first = controller->waiting_queue->first;
-        int target_bank_id = first->bank_id;
+        scheduleRequests(controller);
+    }
+}
 
-        if ((controller->bank_status)[target_bank_id].next_free <= controller->cur_clk)
-        {
-            first->begin_exe = controller->cur_clk;
-            if (first->req_type == READ)
-            {
-                first->end_exe = first->begin_exe + (uint64_t)nclks_read;
-            }
-            else if (first->req_type == WRITE)
-            {
-                first->end_exe = first->begin_exe + (uint64_t)nclks_write;
-            }
-            // The target bank is no longer free until this request completes.
-            (controller->bank_status)[target_bank_id].next_free = first->end_exe;
 
-            migrateToQueue(controller->pending_queue, first);
-            deleteNode(controller->waiting_queue, first);
-        } else{
-            handleBankConflict(controller,first);
+// Earliest clock after cur_clk at which tick() could change the controller state
+uint64_t nextEventClk(Controller *controller)
+{
+    uint64_t next_clk = controller->cur_clk + 1;
+
+    // Completions are retired one per tick, so a backlog keeps every cycle busy
+    Node *first = firstNode(controller->pending_queue);
+    if (first != NULL && first->end_exe <= next_clk)
+    {
+        return next_clk;
+    }
+
+    // Issuing in this tick may have let the other request type go
+    if (issueMode(controller) != controller->issue_mode)
+    {
+        return next_clk;
+    }
+
+    if (controller->config->scheduler == FCFS)
+    {
+        // Only the head may issue, and it may have become the head during this tick;
+        // a new head blocked on its bank is counted as a conflict in the next tick
+        first = fcfsHead(controller);
+        if (first != NULL &&
+            ((controller->bank_status)[first->bank_id].next_free <= next_clk || !first->conflicted))
+        {
+            return next_clk;
         }
-        #endif
+    }
+    // Otherwise every free bank issued, so all waiting requests found their bank busy
+    // and nothing issues before one of the pending events
 
-        #ifdef OOO
-        
-        Node *current_node = controller->waiting_queue->first;
+    while (controller->events->size && earliestEvent(controller->events) <= controller->cur_clk)
+    {
+        popEvent(controller->events);
+    }
 
-        while (current_node != NULL){
-            Node *next_node = current_node->next;
-            int target_bank_id = current_node->bank_id;
+    if (controller->events->size == 0)
+    {
+        return next_clk;
+    }
 
-            if ((controller->bank_status)[target_bank_id].next_free <= controller->cur_clk)
-            {
-                current_node->begin_exe=controller->cur_clk;
-                if (current_node->req_type == READ)
-                {
-                    current_node->end_exe = current_node->begin_exe + (uint64_t)nclks_read;
-                } else if (current_node->req_type == WRITE)
-                {
-                    current_node->end_exe = current_node->begin_exe + (uint64_t)nclks_write;
-                }
-                (controller->bank_status)[target_bank_id].next_free = current_node->end_exe;
+    uint64_t event_clk = earliestEvent(controller->events);
+    return event_clk > next_clk ? event_clk : next_clk;
+}
+
+void advanceClock(Controller *controller, uint64_t cycles)
+{
+    controller->cur_clk += cycles;
+    for (int i = 0; i < controller->num_banks; i++)
+    {
+        (controller->bank_status)[i].cur_clk += cycles;
+    }
+}
 
-                removeBankConflict(controller,current_node);
+// Advance the clocks so that the next tick() lands on the next event; returns the cycles skipped.
+// Only valid when no request will be sent in the meantime.
+uint64_t skipIdleCycles(Controller *controller)
+{
+    uint64_t skipped = nextEventClk(controller) - 1 - controller->cur_clk;
 
-                migrateToQueue(controller->pending_queue, current_node);
-                deleteNode(controller->waiting_queue, current_node);
+    advanceClock(controller, skipped);
 
-            }
-            else{
-                handleBankConflict(controller,current_node);
-            }
-            current_node = next_node;
-        }
-        
-        #endif
+    return skipped;
+}
+
+void freeController(Controller *controller)
+{
+    free(controller->bank_status);
+    free(controller->waiting_queue);
+    free(controller->pending_queue);
+    free(controller->events->events);
+    free(controller->events);
+    free(controller->node_pool->nodes);
+    free(controller->node_pool);
+    free(controller->rank_status);
+    free(controller->group_status);
+    free(controller->channel_status);
+    free(controller->queueing_latency);
+    free(controller->service_latency);
+    free(controller->bank_queues);
+    free(controller->picked);
+    free(controller->arrived_banks);
+    if (controller->queued_writes != NULL)
+    {
+        freeBlockTable(controller->queued_writes);
     }
+    free(controller->batch_load);
+    free(controller);
 }
 
 
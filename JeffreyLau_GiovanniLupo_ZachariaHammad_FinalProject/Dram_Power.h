@@ -0,0 +1,72 @@
+#ifndef __DRAM_POWER_HH__
+#define __DRAM_POWER_HH__
+
+#include "Dram_Timing.h"
+
+// Micron-style current model (TN-40-07): datasheet IDD values of one device, in mA
+typedef struct Dram_Power
+{
+    double VDD; // V
+    double tCK; // ns
+    unsigned devices_per_rank;
+
+    double IDD0; // ACT-PRE cycling
+    double IDD2N; // Precharge standby
+    double IDD2P; // Precharge power-down
+    double IDD3N; // Active standby
+    double IDD3P; // Active power-down
+    double IDD4R; // Burst read
+    double IDD4W; // Burst write
+    double IDD5B; // Burst refresh
+    double IDD6; // Self refresh
+}Dram_Power;
+
+// 8Gb x8 DDR4-2400 like defaults
+void defaultDramPower(Dram_Power *power)
+{
+    power->VDD = 1.2;
+    power->tCK = 0.833;
+    power->devices_per_rank = 8;
+
+    power->IDD0 = 55;
+    power->IDD2N = 34;
+    power->IDD2P = 25;
+    power->IDD3N = 46;
+    power->IDD3P = 37;
+    power->IDD4R = 135;
+    power->IDD4W = 125;
+    power->IDD5B = 250;
+    power->IDD6 = 30;
+}
+
+// Energies of a rank in pJ (mA x V x ns), on top of the background current
+
+double actEnergy(Dram_Power *power, Dram_Timing *timing)
+{
+    double background = power->IDD3N * timing->tRAS + power->IDD2N * (timing->tRC - timing->tRAS);
+    return power->VDD * (power->IDD0 * timing->tRC - background) * power->tCK * power->devices_per_rank;
+}
+
+// One BL8 burst; a block takes controller->bursts of them
+double readEnergy(Dram_Power *power, Dram_Timing *timing)
+{
+    return power->VDD * (power->IDD4R - power->IDD3N) * timing->tCCD * power->tCK * power->devices_per_rank;
+}
+
+double writeEnergy(Dram_Power *power, Dram_Timing *timing)
+{
+    return power->VDD * (power->IDD4W - power->IDD3N) * timing->tCCD * power->tCK * power->devices_per_rank;
+}
+
+// A REFsb only refreshes a fraction of the array, so it is charged for its shorter tRFCsb
+double refreshEnergy(Dram_Power *power, uint64_t tRFC)
+{
+    return power->VDD * (power->IDD5B - power->IDD3N) * tRFC * power->tCK * power->devices_per_rank;
+}
+
+double backgroundEnergy(Dram_Power *power, double idd, uint64_t cycles)
+{
+    return power->VDD * idd * cycles * power->tCK * power->devices_per_rank;
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef __DRAM_TIMING_HH__
+#define __DRAM_TIMING_HH__
+
+#include <stdbool.h>
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h> // uint64_t
+
+typedef enum Page_Policy{OPEN_PAGE, CLOSED_PAGE}Page_Policy;
+
+typedef enum Refresh_Mode{NO_REFRESH, ALL_BANK_REFRESH, SAME_BANK_REFRESH}Refresh_Mode;
+
+#define BURST_LENGTH 8 // Beats per burst (BL8), tCCD clocks at two beats per clock
+
+// DRAM timing parameters, all in memory clocks
+typedef struct Dram_Timing
+{
+    uint64_t tRCD; // ACT to column command
+    uint64_t tCL; // Column command to data
+    uint64_t tRP; // PRE to ACT
+    uint64_t tRAS; // ACT to PRE
+    uint64_t tRC; // ACT to ACT, same bank
+    uint64_t tWR; // End of write data to PRE
+    uint64_t tWTR; // End of write data to read command
+    uint64_t tRTW; // Read column command to write column command, turning the data bus around
+    uint64_t tRRD; // ACT to ACT, different bank groups
+    uint64_t tRRD_L; // ACT to ACT, same bank group
+    uint64_t tFAW; // Window holding at most four ACTs
+    uint64_t tCCD; // Column command to column command, also the burst length
+    uint64_t tCCD_L; // ... within the same bank group
+
+    // Refresh
+    uint64_t tREFI; // Average interval between REF commands to a rank
+    uint64_t tRFC; // REF, all banks
+    uint64_t tRFCsb; // REFsb, one bank in every bank group
+
+    // Low-power states, entered after a rank has been idle for the threshold (0 never enters)
+    uint64_t powerdown_threshold;
+    uint64_t self_refresh_threshold;
+    uint64_t tXP; // Power-down exit
+    uint64_t tXS; // Self-refresh exit
+
+    unsigned row_size; // Bytes per row of a bank
+    unsigned bus_width; // Bytes per beat of a channel's data bus
+    Page_Policy page_policy;
+    Refresh_Mode refresh_mode;
+}Dram_Timing;
+
+// DDR4-2400 like defaults for any parameter the config file leaves out
+void defaultDramTiming(Dram_Timing *timing)
+{
+    timing->tRCD = 16;
+    timing->tCL = 16;
+    timing->tRP = 16;
+    timing->tRAS = 39;
+    timing->tRC = 55;
+    timing->tWR = 18;
+    timing->tWTR = 9;
+    timing->tRTW = 11; // tCL + tCCD + 2 - tCWL
+    timing->tRRD = 6;
+    timing->tRRD_L = 6;
+    timing->tFAW = 26;
+    timing->tCCD = 4;
+    timing->tCCD_L = 4;
+
+    timing->tREFI = 9360; // 7.8 us
+    timing->tRFC = 420; // 350 ns, 8Gb devices
+    timing->tRFCsb = 156; // 130 ns
+
+    timing->powerdown_threshold = 0;
+    timing->self_refresh_threshold = 0;
+    timing->tXP = 8;
+    timing->tXS = 432;
+
+    timing->row_size = 8192;
+    timing->bus_width = 8; // 64-bit channel, 64 bytes per burst
+    timing->page_policy = OPEN_PAGE;
+    timing->refresh_mode = ALL_BANK_REFRESH;
+}
+
+#endif
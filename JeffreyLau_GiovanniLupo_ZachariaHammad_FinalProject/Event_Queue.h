@@ -0,0 +1,81 @@
+#ifndef __EVENT_QUEUE_HH__
+#define __EVENT_QUEUE_HH__
+
+#include <assert.h>
+
+#include <stdlib.h>
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h> // uint64_t
+
+// Binary min-heap of the memory clocks at which some bank or request changes state
+typedef struct Event_Queue
+{
+    uint64_t *events;
+    unsigned capacity;
+    unsigned size;
+}Event_Queue;
+
+Event_Queue* initEventQueue(unsigned capacity)
+{
+    Event_Queue *eq = (Event_Queue *)malloc(sizeof(Event_Queue));
+
+    eq->events = (uint64_t *)malloc(capacity * sizeof(uint64_t));
+    eq->capacity = capacity;
+    eq->size = 0;
+
+    return eq;
+}
+
+void pushEvent(Event_Queue *eq, uint64_t clk)
+{
+    if (eq->size == eq->capacity)
+    {
+        eq->capacity *= 2;
+        eq->events = (uint64_t *)realloc(eq->events, eq->capacity * sizeof(uint64_t));
+        assert(eq->events != NULL);
+    }
+
+    // Sift up
+    unsigned i = eq->size++;
+    while (i > 0 && eq->events[(i - 1) / 2] > clk)
+    {
+        eq->events[i] = eq->events[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    eq->events[i] = clk;
+}
+
+uint64_t earliestEvent(Event_Queue *eq)
+{
+    assert(eq->size > 0);
+    return eq->events[0];
+}
+
+void popEvent(Event_Queue *eq)
+{
+    assert(eq->size > 0);
+
+    // Sift the last event down from the root
+    uint64_t clk = eq->events[--eq->size];
+    unsigned i = 0;
+    while (2 * i + 1 < eq->size)
+    {
+        unsigned child = 2 * i + 1;
+        if (child + 1 < eq->size && eq->events[child + 1] < eq->events[child])
+        {
+            child++;
+        }
+
+        if (eq->events[child] >= clk)
+        {
+            break;
+        }
+
+        eq->events[i] = eq->events[child];
+        i = child;
+    }
+    eq->events[i] = clk;
+}
+
+#endif
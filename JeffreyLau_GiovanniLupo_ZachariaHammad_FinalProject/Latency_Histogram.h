@@ -0,0 +1,88 @@
+#ifndef __LATENCY_HISTOGRAM_HH__
+#define __LATENCY_HISTOGRAM_HH__
+
+#include <stdlib.h>
+#include <math.h>
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h> // uint64_t
+
+// Log-bucketed histogram: exact below 2^SUB_BITS, then 2^SUB_BITS linear buckets per power of two,
+// so any recorded value is off by less than 1/2^SUB_BITS (6.25%)
+#define HISTOGRAM_SUB_BITS 4
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+typedef struct Latency_Histogram
+{
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+}Latency_Histogram;
+
+unsigned histogramBucket(uint64_t value)
+{
+    if (value < HISTOGRAM_SUB_BUCKETS)
+    {
+        return (unsigned)value;
+    }
+
+    unsigned shift = 63 - __builtin_clzll(value) - HISTOGRAM_SUB_BITS;
+    return (shift + 1) * HISTOGRAM_SUB_BUCKETS + (unsigned)((value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+// Largest value that falls in the bucket
+uint64_t bucketHighest(unsigned bucket)
+{
+    if (bucket < HISTOGRAM_SUB_BUCKETS)
+    {
+        return bucket;
+    }
+
+    unsigned shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    uint64_t lowest = (uint64_t)(HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS) << shift;
+    return lowest + ((uint64_t)1 << shift) - 1;
+}
+
+void recordLatency(Latency_Histogram *hist, uint64_t latency)
+{
+    hist->counts[histogramBucket(latency)]++;
+    hist->total++;
+    hist->max = latency > hist->max ? latency : hist->max;
+}
+
+void mergeHistogram(Latency_Histogram *dst, Latency_Histogram *src)
+{
+    for (unsigned i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total += src->total;
+    dst->max = src->max > dst->max ? src->max : dst->max;
+}
+
+// Smallest latency at or above the given fraction of the recorded ones, to within a bucket
+uint64_t histogramPercentile(Latency_Histogram *hist, double fraction)
+{
+    if (hist->total == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)ceil(fraction * hist->total);
+    rank = rank > 0 ? rank : 1;
+
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        seen += hist->counts[i];
+        if (seen >= rank)
+        {
+            uint64_t highest = bucketHighest(i);
+            return highest < hist->max ? highest : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+#endif
@@ -1,31 +1,251 @@
 #include "Trace.h"
 
 #include "Controller.h"
+#include "Parallel.h"
 
 extern TraceParser *initTraceParser(const char * mem_file);
 extern bool getRequest(TraceParser *mem_trace);
 
-extern Controller *initController();
+extern void defaultConfig(Config *config);
+extern Config *loadConfig(const char *config_file);
+extern Controller *initController(Config *config);
 extern unsigned ongoingPendingRequests(Controller *controller);
+extern double bankLevelParallelism(Controller *controller);
+extern bool acceptsRequest(Controller *controller, Request *req);
 extern bool send(Controller *controller, Request *req);
 extern void tick(Controller *controller);
+extern uint64_t skipIdleCycles(Controller *controller);
+extern void finishDramPower(Controller *controller, uint64_t end_clk);
+extern void freeController(Controller *controller);
+
+extern void mergeHistogram(Latency_Histogram *dst, Latency_Histogram *src);
+extern uint64_t histogramPercentile(Latency_Histogram *hist, double fraction);
+
+extern Parallel_Sim *initParallelSim(Config *config);
+extern uint64_t runParallelSim(Parallel_Sim *sim, TraceParser *trace);
+extern void freeParallelSim(Parallel_Sim *sim);
+
+static const char *req_type_names[2] = {"Read", "Write"};
+
+TraceParser *openTrace(const char *mem_file, Config *config)
+{
+    TraceParser *mem_trace = initTraceParser(mem_file);
+    // PAR-BS and BLISS keep per-core state for at most MAX_CORES cores
+    if (config->scheduler == PAR_BS || config->scheduler == BLISS)
+    {
+        mem_trace->num_cores = MAX_CORES;
+    }
+    return mem_trace;
+}
+
+void printLatency(const char *prefix, const char *req_type, Latency_Histogram *queueing, Latency_Histogram *service)
+{
+    if (queueing->total == 0)
+    {
+        return;
+    }
+
+    printf("%s%s Latency p50/p90/p99/p999: queueing ""%"PRIu64"/""%"PRIu64"/""%"PRIu64"/""%"PRIu64
+           ", service ""%"PRIu64"/""%"PRIu64"/""%"PRIu64"/""%"PRIu64"\n", prefix, req_type,
+           histogramPercentile(queueing, 0.5), histogramPercentile(queueing, 0.9),
+           histogramPercentile(queueing, 0.99), histogramPercentile(queueing, 0.999),
+           histogramPercentile(service, 0.5), histogramPercentile(service, 0.9),
+           histogramPercentile(service, 0.99), histogramPercentile(service, 0.999));
+}
+
+// One controller, or one per channel in parallel mode
+void printStats(uint64_t cycles, Controller **controllers, unsigned num_controllers, bool configured)
+{
+    unsigned bank_conflicts = 0;
+    uint64_t stall_cycles[NUM_STALL_CAUSES] = {0};
+    uint64_t row_hits = 0;
+    uint64_t row_misses = 0;
+    uint64_t row_conflicts = 0;
+    uint64_t write_drains = 0;
+    uint64_t forwarded_reads = 0;
+    uint64_t turnarounds = 0;
+    uint64_t blocks = 0; // Moved over the data bus
+    uint64_t refreshes = 0;
+    uint64_t powerdown_cycles = 0;
+    uint64_t self_refresh_cycles = 0;
+    double energy[5] = {0}; // ACT/PRE, RD, WR, REF, background
+    Latency_Histogram *queueing = (Latency_Histogram *)calloc(2, sizeof(Latency_Histogram));
+    Latency_Histogram *service = (Latency_Histogram *)calloc(2, sizeof(Latency_Histogram));
+    for (unsigned i = 0; i < num_controllers; i++)
+    {
+        Controller *controller = controllers[i];
+        bank_conflicts += controller->bank_conflicts;
+        for (unsigned b = 0; b < controller->num_banks; b++)
+        {
+            for (unsigned s = 0; s < NUM_STALL_CAUSES; s++)
+            {
+                stall_cycles[s] += (controller->bank_status)[b].stall_cycles[s];
+            }
+        }
+        row_hits += controller->row_hits;
+        row_misses += controller->row_misses;
+        row_conflicts += controller->row_conflicts;
+        write_drains += controller->write_drains;
+        forwarded_reads += controller->forwarded_reads;
+        turnarounds += controller->turnarounds;
+        for (unsigned b = 0; b < controller->num_banks; b++)
+        {
+            for (unsigned t = 0; t < 2; t++)
+            {
+                mergeHistogram(&queueing[t], &(controller->queueing_latency)[2 * b + t]);
+                mergeHistogram(&service[t], &(controller->service_latency)[2 * b + t]);
+            }
+        }
+
+        if (controller->timing != NULL)
+        {
+            finishDramPower(controller, cycles);
+            blocks += controller->reads + controller->writes;
+            refreshes += controller->refreshes;
+            for (unsigned r = 0; r < controller->mapping.channels * controller->mapping.ranks; r++)
+            {
+                powerdown_cycles += (controller->rank_status)[r].powerdown_cycles;
+                self_refresh_cycles += (controller->rank_status)[r].self_refresh_cycles;
+            }
+            energy[0] += controller->act_energy;
+            energy[1] += controller->read_energy;
+            energy[2] += controller->write_energy;
+            energy[3] += controller->refresh_energy;
+            energy[4] += controller->background_energy;
+        }
+    }
+
+    printf("End Execution Time: ""%"PRIu64"\n", cycles);
+    if (controllers[0]->timing != NULL)
+    {
+        double total = energy[0] + energy[1] + energy[2] + energy[3] + energy[4];
+        printf("Energy per Bit: %lf pJ\n", blocks ? total / (blocks * BLOCK_SIZE * 8) : 0.0);
+    }
+    printf("Num Bank Conflicts: %u\n", bank_conflicts);
+    printf("Stall Cycles: %s ""%"PRIu64", %s ""%"PRIu64"\n", stall_cause_names[STALL_BANK_BUSY],
+           stall_cycles[STALL_BANK_BUSY], stall_cause_names[STALL_HELD_BACK], stall_cycles[STALL_HELD_BACK]);
+    if (controllers[0]->timing != NULL)
+    {
+        printf("Row Hits: ""%"PRIu64"\n", row_hits);
+        printf("Row Misses: ""%"PRIu64"\n", row_misses);
+        printf("Row Conflicts: ""%"PRIu64"\n", row_conflicts);
+        printf("Bus Turnarounds: ""%"PRIu64"\n", turnarounds);
+        printf("Refreshes: ""%"PRIu64"\n", refreshes);
+        printf("Rank Power-Down Cycles: ""%"PRIu64", Self-Refresh Cycles: ""%"PRIu64"\n", powerdown_cycles, self_refresh_cycles);
+        printf("DRAM Energy (nJ): ACT/PRE %.1lf, RD %.1lf, WR %.1lf, REF %.1lf, Background %.1lf\n",
+               energy[0] / 1000, energy[1] / 1000, energy[2] / 1000, energy[3] / 1000, energy[4] / 1000);
+    }
+
+    for (unsigned t = 0; t < 2; t++)
+    {
+        printLatency("", req_type_names[t], &queueing[t], &service[t]);
+    }
+    free(queueing);
+    free(service);
+
+    if (controllers[0]->config->write_queue_size)
+    {
+        printf("Write Drains: ""%"PRIu64"\n", write_drains);
+        printf("Forwarded Reads: ""%"PRIu64"\n", forwarded_reads);
+    }
+
+    if (configured)
+    {
+        Config *config = controllers[0]->config;
+        for (unsigned i = 0; i < num_controllers; i++)
+        {
+            if (num_controllers > 1)
+            {
+                printf("Channel %u ", i);
+            }
+            printf("Bank-Level Parallelism (%s%s): %lf\n", config->address_mapping,
+                   config->bank_xor ? ", XOR" : "", bankLevelParallelism(controllers[i]));
+        }
+
+        for (unsigned i = 0; i < num_controllers; i++)
+        {
+            for (unsigned b = 0; b < controllers[i]->num_banks; b++)
+            {
+                char prefix[64];
+                if (num_controllers > 1)
+                {
+                    sprintf(prefix, "Channel %u Bank %u ", i, b);
+                }
+                else
+                {
+                    sprintf(prefix, "Bank %u ", b);
+                }
+
+                Bank *bank = &(controllers[i]->bank_status)[b];
+                printf("%sConflicts: ""%"PRIu64", Stall Cycles: %s ""%"PRIu64", %s ""%"PRIu64"\n", prefix,
+                       bank->conflicts, stall_cause_names[STALL_BANK_BUSY], bank->stall_cycles[STALL_BANK_BUSY],
+                       stall_cause_names[STALL_HELD_BACK], bank->stall_cycles[STALL_HELD_BACK]);
+                for (unsigned t = 0; t < 2; t++)
+                {
+                    printLatency(prefix, req_type_names[t], &(controllers[i]->queueing_latency)[2 * b + t],
+                                 &(controllers[i]->service_latency)[2 * b + t]);
+                }
+            }
+        }
+    }
+}
 
 int main(int argc, const char *argv[])
 {	
-    if (argc != 2)
+    if (argc != 2 && argc != 3)
     {
-        printf("Usage: %s %s\n", argv[0], "<mem-file>");
+        printf("Usage: %s %s\n", argv[0], "<mem-file> [<dram-config>]");
 
         return 0;
     }
 
-    // Initialize a CPU trace parser
-    TraceParser *mem_trace = initTraceParser(argv[1]);
+    // Without a config, every request takes a flat nclks_read/nclks_write and OOO schedules them
+    Config *config = NULL;
+    if (argc == 3)
+    {
+        if ((config = loadConfig(argv[2])) == NULL)
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        config = (Config *)malloc(sizeof(Config));
+        defaultConfig(config);
+    }
+
+    if (config->threads > 0)
+    {
+        Parallel_Sim *sim = initParallelSim(config);
+        if (sim == NULL)
+        {
+            return 0;
+        }
+
+        uint64_t cycles = runParallelSim(sim, openTrace(argv[1], config));
+
+        Controller **controllers = (Controller **)malloc(sim->num_channels * sizeof(Controller *));
+        for (unsigned c = 0; c < sim->num_channels; c++)
+        {
+            controllers[c] = (sim->channels)[c].controller;
+        }
+        printStats(cycles, controllers, sim->num_channels, true);
+
+        free(controllers);
+        freeParallelSim(sim);
+        free(config);
+        return 0;
+    }
 
     // Initialize a Controller
-    Controller *controller = initController();
-    // printf("%u\n", controller->bank_shift);
-    // printf("%u\n", controller->bank_mask);
+    Controller *controller = initController(config);
+    if (controller == NULL)
+    {
+        return 0;
+    }
+
+    // Initialize a CPU trace parser
+    TraceParser *mem_trace = openTrace(argv[1], config);
 
     uint64_t cycles = 0;
 
@@ -46,12 +266,18 @@ int main(int argc, const char *argv[])
 
         tick(controller);
         ++cycles;
+
+        #ifdef IDLE_SKIPPING
+        // Nothing new arrives once the trace ends or while the waiting queue stays full
+        if (end || (stall && !acceptsRequest(controller, mem_trace->cur_req)))
+        {
+            cycles += skipIdleCycles(controller);
+        }
+        #endif
     }
 
-    free(controller->bank_status);
-    free(controller->waiting_queue);
-    free(controller->pending_queue);
-    free(controller);
-    printf("End Execution Time: ""%"PRIu64"\n", cycles);
-    printf("Num Bank Conflicts: %u\n", controller->bank_conflicts);
+    printStats(cycles, &controller, 1, argc == 3);
+
+    freeController(controller);
+    free(config);
 }
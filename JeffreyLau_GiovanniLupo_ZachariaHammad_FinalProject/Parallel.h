@@ -0,0 +1,366 @@
+#ifndef __PARALLEL_HH__
+#define __PARALLEL_HH__
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "Trace.h"
+#include "Controller.h"
+
+/*
+ * Parallel mode: every channel has its own controller, waiting queue included, and runs on
+ * one of the worker threads. The main thread routes the trace, one request per cycle, into
+ * a ring per channel. Channels only meet at the epoch barriers, so the results do not depend
+ * on the number of threads.
+ */
+
+// A request stamped with the cycle it reaches its channel
+typedef struct Routed_Request
+{
+    uint64_t arrival;
+    Request req;
+}Routed_Request;
+
+// Single-producer single-consumer ring between the router and a channel
+typedef struct Spsc_Ring
+{
+    Routed_Request *slots;
+    uint64_t capacity; // Power of two
+    _Atomic uint64_t head; // Next slot to consume
+    _Atomic uint64_t tail; // Next slot to produce
+}Spsc_Ring;
+
+typedef struct Channel
+{
+    Controller *controller;
+    Spsc_Ring ring;
+
+    // Arrived requests the waiting queue has not taken yet, oldest first
+    Routed_Request *ingress;
+    uint64_t ingress_capacity;
+    uint64_t ingress_head;
+    uint64_t ingress_size;
+
+    uint64_t finish_clk; // Last cycle with work outstanding
+}Channel;
+
+typedef struct Parallel_Sim
+{
+    Config *config;
+    Address_Mapping mapping; // For routing
+
+    unsigned num_channels;
+    unsigned num_threads;
+    Channel *channels;
+    pthread_t *threads;
+
+    uint64_t epoch; // Cycles between barriers
+    pthread_barrier_t barrier;
+
+    // Written before barrier k into slot k % 2, read after it
+    bool *idle[2];
+    bool trace_done[2];
+
+    TraceParser *trace;
+    bool trace_ended;
+    uint64_t routed; // Requests routed so far; request i arrives at cycle i + 1
+}Parallel_Sim;
+
+typedef struct Worker_Arg
+{
+    Parallel_Sim *sim;
+    unsigned id;
+}Worker_Arg;
+
+void initSpscRing(Spsc_Ring *ring, uint64_t min_capacity)
+{
+    ring->capacity = 1;
+    while (ring->capacity < min_capacity)
+    {
+        ring->capacity *= 2;
+    }
+    ring->slots = (Routed_Request *)malloc(ring->capacity * sizeof(Routed_Request));
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+}
+
+bool ringPush(Spsc_Ring *ring, Routed_Request *item)
+{
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail - head == ring->capacity)
+    {
+        return false;
+    }
+
+    ring->slots[tail & (ring->capacity - 1)] = *item;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+Routed_Request *ringPeek(Spsc_Ring *ring)
+{
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head == tail ? NULL : &ring->slots[head & (ring->capacity - 1)];
+}
+
+void ringPop(Spsc_Ring *ring)
+{
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+Routed_Request *ingressHead(Channel *ch)
+{
+    return ch->ingress_size ? &ch->ingress[ch->ingress_head] : NULL;
+}
+
+void pushIngress(Channel *ch, Routed_Request *item)
+{
+    if (ch->ingress_size == ch->ingress_capacity)
+    {
+        // Unwrap into a buffer twice the size
+        Routed_Request *ingress = (Routed_Request *)malloc(2 * ch->ingress_capacity * sizeof(Routed_Request));
+        for (uint64_t i = 0; i < ch->ingress_size; i++)
+        {
+            ingress[i] = ch->ingress[(ch->ingress_head + i) % ch->ingress_capacity];
+        }
+        free(ch->ingress);
+        ch->ingress = ingress;
+        ch->ingress_head = 0;
+        ch->ingress_capacity *= 2;
+    }
+
+    ch->ingress[(ch->ingress_head + ch->ingress_size) % ch->ingress_capacity] = *item;
+    ch->ingress_size++;
+}
+
+void popIngress(Channel *ch)
+{
+    ch->ingress_head = (ch->ingress_head + 1) % ch->ingress_capacity;
+    ch->ingress_size--;
+}
+
+// Simulate one channel up to and including cycle epoch_end
+void runChannelEpoch(Channel *ch, uint64_t epoch_end)
+{
+    Controller *controller = ch->controller;
+
+    // Everything arriving in this epoch was routed before the last barrier
+    Routed_Request *item;
+    while ((item = ringPeek(&ch->ring)) != NULL && item->arrival <= epoch_end)
+    {
+        pushIngress(ch, item);
+        ringPop(&ch->ring);
+    }
+
+    while (controller->cur_clk < epoch_end)
+    {
+        // Like the trace front end, one arrived request a cycle enters the waiting queue if it has room
+        item = ingressHead(ch);
+        bool arrived = item != NULL && item->arrival <= controller->cur_clk + 1;
+        if (arrived && send(controller, &item->req))
+        {
+            popIngress(ch);
+        }
+
+        bool busy = ongoingPendingRequests(controller) || arrived;
+        tick(controller);
+        if (busy)
+        {
+            ch->finish_clk = controller->cur_clk;
+        }
+
+        // Jump to the next event, the next admissible arrival, or the end of the epoch
+        uint64_t next_clk = epoch_end + 1;
+        if (ongoingPendingRequests(controller))
+        {
+            next_clk = nextEventClk(controller);
+        }
+        item = ingressHead(ch);
+        if (item != NULL && acceptsRequest(controller, &item->req))
+        {
+            uint64_t arrival_clk = item->arrival > controller->cur_clk + 1 ? item->arrival : controller->cur_clk + 1;
+            next_clk = arrival_clk < next_clk ? arrival_clk : next_clk;
+        }
+
+        uint64_t target_clk = next_clk - 1 < epoch_end ? next_clk - 1 : epoch_end;
+        if (target_clk > controller->cur_clk)
+        {
+            advanceClock(controller, target_clk - controller->cur_clk);
+        }
+    }
+}
+
+// Route the requests arriving up to and including cycle last_arrival
+void routeRequests(Parallel_Sim *sim, uint64_t last_arrival)
+{
+    while (!sim->trace_ended && sim->routed < last_arrival)
+    {
+        if (!getRequest(sim->trace))
+        {
+            sim->trace_ended = true;
+            break;
+        }
+
+        Dram_Address dram_addr;
+        decodeAddress(&sim->mapping, sim->trace->cur_req->memory_address, &dram_addr);
+
+        Routed_Request item;
+        item.arrival = ++sim->routed;
+        item.req = *sim->trace->cur_req;
+
+        // The channel drains its ring at the start of every epoch, so this only waits briefly
+        while (!ringPush(&(sim->channels)[dram_addr.channel].ring, &item))
+        {
+            sched_yield();
+        }
+    }
+}
+
+// Epoch k covers cycles (k * epoch, (k + 1) * epoch]
+bool epochBarrier(Parallel_Sim *sim, uint64_t k)
+{
+    pthread_barrier_wait(&sim->barrier);
+
+    if (!sim->trace_done[k % 2])
+    {
+        return false;
+    }
+    for (unsigned c = 0; c < sim->num_channels; c++)
+    {
+        if (!(sim->idle[k % 2])[c])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void *channelWorker(void *_arg)
+{
+    Worker_Arg *arg = (Worker_Arg *)_arg;
+    Parallel_Sim *sim = arg->sim;
+
+    for (uint64_t k = 0; ; k++)
+    {
+        for (unsigned c = arg->id; c < sim->num_channels; c += sim->num_threads)
+        {
+            Channel *ch = &(sim->channels)[c];
+            runChannelEpoch(ch, (k + 1) * sim->epoch);
+
+            // Once the trace has ended, every routed request is already in the ingress
+            (sim->idle[k % 2])[c] = !ongoingPendingRequests(ch->controller) && ch->ingress_size == 0;
+        }
+
+        if (epochBarrier(sim, k))
+        {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+Parallel_Sim *initParallelSim(Config *config)
+{
+    Parallel_Sim *sim = (Parallel_Sim *)malloc(sizeof(Parallel_Sim));
+    sim->config = config;
+    sim->epoch = config->epoch;
+
+    if (!initAddressMapping(&sim->mapping, config->address_mapping, BLOCK_SIZE,
+                            config->channels, config->ranks, config->bank_groups, config->banks,
+                            config->timing.row_size / BLOCK_SIZE, config->bank_xor != 0))
+    {
+        free(sim);
+        return NULL;
+    }
+
+    sim->num_channels = config->channels;
+    sim->num_threads = config->threads < config->channels ? config->threads : config->channels;
+    sim->channels = (Channel *)malloc(sim->num_channels * sizeof(Channel));
+    for (unsigned c = 0; c < sim->num_channels; c++)
+    {
+        Channel *ch = &(sim->channels)[c];
+        ch->controller = initChannelController(config, 1);
+        initSpscRing(&ch->ring, 2 * sim->epoch);
+        ch->ingress_capacity = MAX_WAITING_QUEUE_SIZE;
+        ch->ingress = (Routed_Request *)malloc(ch->ingress_capacity * sizeof(Routed_Request));
+        ch->ingress_head = 0;
+        ch->ingress_size = 0;
+        ch->finish_clk = 0;
+    }
+
+    sim->threads = (pthread_t *)malloc(sim->num_threads * sizeof(pthread_t));
+    sim->idle[0] = (bool *)calloc(sim->num_channels, sizeof(bool));
+    sim->idle[1] = (bool *)calloc(sim->num_channels, sizeof(bool));
+    pthread_barrier_init(&sim->barrier, NULL, sim->num_threads + 1);
+
+    return sim;
+}
+
+// Returns the end execution time, the last cycle any channel had work
+uint64_t runParallelSim(Parallel_Sim *sim, TraceParser *trace)
+{
+    sim->trace = trace;
+    sim->trace_ended = false;
+    sim->routed = 0;
+
+    // The router stays one epoch ahead of the channels
+    routeRequests(sim, sim->epoch);
+
+    Worker_Arg *args = (Worker_Arg *)malloc(sim->num_threads * sizeof(Worker_Arg));
+    for (unsigned t = 0; t < sim->num_threads; t++)
+    {
+        args[t].sim = sim;
+        args[t].id = t;
+        pthread_create(&(sim->threads)[t], NULL, channelWorker, &args[t]);
+    }
+
+    for (uint64_t k = 0; ; k++)
+    {
+        sim->trace_done[k % 2] = sim->trace_ended;
+        routeRequests(sim, (k + 2) * sim->epoch);
+
+        if (epochBarrier(sim, k))
+        {
+            break;
+        }
+    }
+
+    for (unsigned t = 0; t < sim->num_threads; t++)
+    {
+        pthread_join((sim->threads)[t], NULL);
+    }
+    free(args);
+
+    uint64_t cycles = sim->routed;
+    for (unsigned c = 0; c < sim->num_channels; c++)
+    {
+        uint64_t finish_clk = (sim->channels)[c].finish_clk;
+        cycles = finish_clk > cycles ? finish_clk : cycles;
+    }
+    return cycles;
+}
+
+void freeParallelSim(Parallel_Sim *sim)
+{
+    for (unsigned c = 0; c < sim->num_channels; c++)
+    {
+        Channel *ch = &(sim->channels)[c];
+        freeController(ch->controller);
+        free(ch->ring.slots);
+        free(ch->ingress);
+    }
+
+    pthread_barrier_destroy(&sim->barrier);
+    free(sim->channels);
+    free(sim->threads);
+    free(sim->idle[0]);
+    free(sim->idle[1]);
+    free(sim);
+}
+
+#endif
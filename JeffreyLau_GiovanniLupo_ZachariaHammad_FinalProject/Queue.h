@@ -5,177 +5,281 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 
 #include <math.h>
 
 #include "Request.h"
 
+#define NIL_NODE -1 // End of a queue, or of the free list
+
 // Each Node stores one request
-struct Node;
-typedef struct Node Node;
 typedef struct Node
 {
     uint64_t mem_addr;
     Request_Type req_type; // Request type
 
     int bank_id; // Which bank the request targets to
+    uint64_t row_id;
+    int core_id;
+
+    // Scheduling informations.
+    uint64_t arrival; // Arrival order
+    bool marked; // Part of the current PAR-BS batch
+    bool conflicted; // Already counted as a bank conflict
 
     // Some timing informations.
+    uint64_t arrival_clk; // First clock the controller sees the request
     uint64_t begin_exe;
     uint64_t end_exe;
-    Node *prev;
-    Node *next;
+
+    // Links are slots in the pool, so a node moves between queues without being copied
+    int prev;
+    int next;
+
+    // Links within the waiting requests of the same bank
+    int bank_prev;
+    int bank_next;
 }Node;
 
+// Every queue of a controller draws its nodes from one preallocated pool
+typedef struct Node_Pool
+{
+    Node *nodes;
+    int capacity;
+    int free_head; // Free nodes are chained through next
+}Node_Pool;
+
 typedef struct Queue
 {
-    Node *first;
-    Node *last;
+    Node_Pool *pool;
+
+    int first;
+    int last;
 
     unsigned size; // Current size of the queue
 }Queue;
 
-Queue* initQueue()
+// Waiting requests of one bank, oldest first, threaded through the same pool nodes
+typedef struct Bank_Queue
+{
+    int first;
+    int last;
+    int first_unflagged; // Requests from here on have not been counted as conflicts yet
+
+    unsigned size;
+}Bank_Queue;
+
+void chainFreeNodes(Node_Pool *pool, int from)
+{
+    for (int i = from; i < pool->capacity; i++)
+    {
+        pool->nodes[i].next = i + 1 < pool->capacity ? i + 1 : pool->free_head;
+    }
+    pool->free_head = from;
+}
+
+Node_Pool* initNodePool(unsigned capacity)
+{
+    Node_Pool *pool = (Node_Pool *)malloc(sizeof(Node_Pool));
+
+    pool->nodes = (Node *)malloc(capacity * sizeof(Node));
+    pool->capacity = capacity;
+    pool->free_head = NIL_NODE;
+    chainFreeNodes(pool, 0);
+
+    return pool;
+}
+
+// Only called when every node is in use; doubling keeps the number of reallocs logarithmic
+void growNodePool(Node_Pool *pool)
+{
+    int old_capacity = pool->capacity;
+
+    pool->capacity *= 2;
+    pool->nodes = (Node *)realloc(pool->nodes, pool->capacity * sizeof(Node));
+    assert(pool->nodes != NULL);
+    chainFreeNodes(pool, old_capacity);
+}
+
+Queue* initQueue(Node_Pool *pool)
 {
     Queue *q = (Queue *)malloc(sizeof(Queue));
 
-    q->first = NULL;
-    q->last = NULL;
+    q->pool = pool;
+    q->first = NIL_NODE;
+    q->last = NIL_NODE;
     q->size = 0;
 
     return q;
 }	
 
-// Push a request to the queue
-void pushToQueue(Queue *q, Request *req)
+Node *nodeAt(Queue *q, int idx)
 {
-    Node *node = (Node *)malloc(sizeof(Node));
-    node->mem_addr = req->memory_address;
-    node->req_type = req->req_type;
-    node->bank_id = req->bank_id;
+    return idx == NIL_NODE ? NULL : &q->pool->nodes[idx];
+}
+
+Node *firstNode(Queue *q)
+{
+    return nodeAt(q, q->first);
+}
+
+Node *nextNode(Queue *q, Node *node)
+{
+    return nodeAt(q, node->next);
+}
+
+// Append the pool node idx to the queue
+void linkNode(Queue *q, int idx)
+{
+    Node *node = &q->pool->nodes[idx];
 
-    node->prev = NULL;
-    node->next = NULL;
+    node->prev = q->last;
+    node->next = NIL_NODE;
 
     // Check if the queue is empty.
-    if (q->first == NULL && q->last == NULL)
+    if (q->first == NIL_NODE)
     {
-        q->first = node;
-        q->last = node;
-        q->size = 1;
+        q->first = idx;
     }
     else
     {
         // Now, the new node becomes the last node of the queue.
-        node->prev = q->last;
-        q->last->next = node;
-
-        q->last = node;
-        q->size = q->size + 1;
+        q->pool->nodes[q->last].next = idx;
     }
 
-    /*
-    // print the queue
-    Node *iter = q->first;
-    while (iter != NULL)
-    {
-        printf("(""%"PRIu64, iter->mem_addr);
-        printf(" : ");
-        printf("%d)", iter->bank_id);
-
-        iter = iter->next;
-        if (iter != NULL)
-        {
-            printf(" -> ");
-        }
-    }
-    printf("\n");
-    */
+    q->last = idx;
+    q->size = q->size + 1;
 }
 
-void migrateToQueue(Queue *q, Node *_node)
+// Take the node out of the queue, leaving it in the pool
+int unlinkNode(Queue *q, Node *node)
 {
-    Node *node = (Node *)malloc(sizeof(Node));
-    node->mem_addr = _node->mem_addr;
-    node->req_type = _node->req_type;
-    node->bank_id = _node->bank_id;
-    node->begin_exe = _node->begin_exe;
-    node->end_exe = _node->end_exe;
-
-    node->prev = NULL;
-    node->next = NULL;
+    int idx = (int)(node - q->pool->nodes);
 
-    // Check if the queue is empty.
-    if (q->first == NULL && q->last == NULL)
+    if (node->prev == NIL_NODE)
     {
-        q->first = node;
-        q->last = node;
-        q->size = 1;
+        q->first = node->next; // Node's next node becomes the first node
     }
     else
     {
-        // Now, the new node becomes the last node of the queue.
-        node->prev = q->last;
-        q->last->next = node;
-
-        q->last = node;
-        q->size = q->size + 1;
+        q->pool->nodes[node->prev].next = node->next;
     }
 
-    /*
-    // print the queue
-    Node *iter = q->first;
-    while (iter != NULL)
+    if (node->next == NIL_NODE)
+    {
+        q->last = node->prev; // Node's previous node becomes the last node
+    }
+    else
     {
-        printf("(""%"PRIu64, iter->mem_addr);
-        printf(" : ");
-        printf("%d)", iter->bank_id);
+        q->pool->nodes[node->next].prev = node->prev;
+    }
+
+    q->size = q->size - 1;
+
+    return idx;
+}
 
-        iter = iter->next;
-        if (iter != NULL)
-        {
-            printf(" -> ");
-        }
+// Push a request to the queue; this may grow the pool, so Node pointers held across it go stale
+Node *pushToQueue(Queue *q, Request *req)
+{
+    Node_Pool *pool = q->pool;
+    if (pool->free_head == NIL_NODE)
+    {
+        growNodePool(pool);
     }
-    printf("\n");
-    */
+
+    int idx = pool->free_head;
+    Node *node = &pool->nodes[idx];
+    pool->free_head = node->next;
+
+    node->mem_addr = req->memory_address;
+    node->req_type = req->req_type;
+    node->bank_id = req->bank_id;
+    node->row_id = req->row_id;
+    node->core_id = req->core_id;
+    node->marked = false;
+    node->conflicted = false;
+
+    linkNode(q, idx);
+
+    return node;
+}
+
+// Move the node from src to the end of dst; both queues must share a pool
+void migrateToQueue(Queue *src, Queue *dst, Node *node)
+{
+    assert(src->pool == dst->pool);
+
+    linkNode(dst, unlinkNode(src, node));
 }
 
 void deleteNode(Queue *q, Node *node)
 {
-    q->size = q->size - 1;
+    int idx = unlinkNode(q, node);
 
-    if (node == q->first && node == q->last)
-    {
-        q->first = NULL;
-        q->last = NULL;
+    node->next = q->pool->free_head;
+    q->pool->free_head = idx;
+}
 
-        free(node);
+void initBankQueue(Bank_Queue *bq)
+{
+    bq->first = NIL_NODE;
+    bq->last = NIL_NODE;
+    bq->first_unflagged = NIL_NODE;
+    bq->size = 0;
+}
+
+void linkToBank(Node_Pool *pool, Bank_Queue *bq, Node *node)
+{
+    int idx = (int)(node - pool->nodes);
+
+    node->bank_prev = bq->last;
+    node->bank_next = NIL_NODE;
+
+    if (bq->first == NIL_NODE)
+    {
+        bq->first = idx;
     }
-    else if (node == q->first && node != q->last)
+    else
     {
-        q->first = node->next; // Node's next node becomes the first node
-        q->first->prev = NULL;
+        pool->nodes[bq->last].bank_next = idx;
+    }
 
-        free(node);
+    bq->last = idx;
+    if (bq->first_unflagged == NIL_NODE)
+    {
+        bq->first_unflagged = idx;
     }
-    else if (node != q->first && node == q->last)
+    bq->size = bq->size + 1;
+}
+
+void unlinkFromBank(Node_Pool *pool, Bank_Queue *bq, Node *node)
+{
+    if (bq->first_unflagged == (int)(node - pool->nodes))
     {
-        q->last = node->prev; // Node's previous node becomes the last node
-        q->last->next = NULL;
+        bq->first_unflagged = node->bank_next;
+    }
 
-        free(node);
+    if (node->bank_prev == NIL_NODE)
+    {
+        bq->first = node->bank_next;
     }
     else
     {
-        Node *prev = node->prev;
-        Node *next = node->next;
-
-        prev->next = next;
-        next->prev = prev;
+        pool->nodes[node->bank_prev].bank_next = node->bank_next;
+    }
 
-        free(node);
+    if (node->bank_next == NIL_NODE)
+    {
+        bq->last = node->bank_prev;
     }
+    else
+    {
+        pool->nodes[node->bank_next].bank_prev = node->bank_prev;
+    }
+
+    bq->size = bq->size - 1;
 }
 
 #endif
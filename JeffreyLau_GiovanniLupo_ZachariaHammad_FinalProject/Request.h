@@ -12,9 +12,11 @@ typedef struct Request
     Request_Type req_type;
 
     uint64_t memory_address;
+    int core_id; // Issuing core, 0 when the trace does not say
 
     /* Decoding Info */
     int bank_id; // Which bank it targets to.
+    uint64_t row_id; // Which row of that bank
 
 }Request;
 
@@ -6,6 +6,7 @@ TraceParser *initTraceParser(const char * mem_file)
 
     trace_parser->fd = fopen(mem_file, "r");
     trace_parser->cur_req = (Request *)malloc(sizeof(Request));
+    trace_parser->num_cores = INT_MAX;
 
     return trace_parser;
 }
@@ -34,8 +35,24 @@ bool getRequest(TraceParser *mem_trace)
             req_type = WRITE;
         }
 
+        // Optional third column, the issuing core
+        ptr = strtok(NULL, delim);
+        int core_id = 0;
+        if (ptr != NULL)
+        {
+            char *rest;
+            unsigned long id = strtoul(ptr, &rest, 10);
+            if (ptr[0] == '-' || *rest != '\0' || id >= mem_trace->num_cores)
+            {
+                printf("Bad core id %s, must be below %u\n", ptr, mem_trace->num_cores);
+                exit(1);
+            }
+            core_id = (int)id;
+        }
+
         mem_trace->cur_req->req_type = req_type;
         mem_trace->cur_req->memory_address = mem_addr;
+        mem_trace->cur_req->core_id = core_id;
 
         free(line);
         line = NULL;
@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 #include "Request.h"
 
@@ -13,6 +14,8 @@ typedef struct TraceParser
     FILE *fd; // file descriptor for the trace file
 
     Request *cur_req; // current instruction
+
+    unsigned num_cores; // Core ids in the trace must be below this
 }TraceParser;
 
 // Define functions
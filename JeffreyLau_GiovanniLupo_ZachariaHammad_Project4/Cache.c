@@ -1,4 +1,5 @@
 #include "Cache.h"
+#include "Coherence.h"
 
 
 /* Constants */
@@ -10,6 +11,12 @@ const unsigned block_size = 64; // Size of a cache line (in Bytes)
 const unsigned cache_size = 128; // Size of a cache (in KB)
 // TODO, you should try different associativity configurations, for example, 4, 8, 16
 const unsigned assoc = 16;
+// Set sampling models one out of (1 << set_sample_shift) sets
+const unsigned set_sample_shift = 5;
+// Number of cores sharing the cache (core_id in the trace must be below this)
+const unsigned num_cores = 4;
+// A demand hit this soon after the prefetch was issued would still have waited for the fill
+const uint64_t prefetch_latency = 200;
 
 Cache *initCache()
 {
@@ -18,6 +25,9 @@ Cache *initCache()
     cache->blk_mask = block_size - 1;
     cache->max_rrpv = 3; 
     unsigned num_blocks = cache_size * 1024 / block_size;
+    #ifdef SET_SAMPLING
+    num_blocks >>= set_sample_shift;
+    #endif
     cache->num_blocks = num_blocks;
     // printf("Num of blocks: %u\n", cache->num_blocks);
 
@@ -31,6 +41,15 @@ Cache *initCache()
         cache->blocks[i].dirty = false;
         cache->blocks[i].when_touched = 0;
         cache->blocks[i].frequency = 0;
+        cache->blocks[i].next_use = UINT64_MAX;
+        cache->blocks[i].signature = UINT64_MAX;
+        cache->blocks[i].rrpv = 0;
+        cache->blocks[i].outcome = false;
+        cache->blocks[i].prefetch = false;
+        cache->blocks[i].prefetcher_id = -1;
+        cache->blocks[i].prefetch_time = 0;
+        cache->blocks[i].PC = 0;
+        cache->blocks[i].core_id = -1;
     }
 
     // Initialize Set-way variables
@@ -51,6 +70,21 @@ Cache *initCache()
     cache->tag_shift = tag_shift;
     // printf("Tag shift: %u\n", cache->tag_shift);
 
+    #ifdef SET_SAMPLING
+    // Model the sets whose low set_sample_shift index bits are zero; the tag keeps its full width
+    assert(num_sets >> set_sample_shift > 0);
+    cache->sample_shift = set_sample_shift;
+    cache->sample_mask = (((uint64_t)1 << set_sample_shift) - 1) << set_shift;
+
+    num_sets >>= set_sample_shift;
+    cache->num_sets = num_sets;
+    cache->set_shift = set_shift + set_sample_shift;
+    cache->set_mask = num_sets - 1;
+
+    cache->set_accesses = (uint64_t *)calloc(num_sets, sizeof(uint64_t));
+    cache->set_hits = (uint64_t *)calloc(num_sets, sizeof(uint64_t));
+    #endif
+
     // Initialize Sets
     cache->sets = (Set *)malloc(num_sets * sizeof(Set));
     for (unsigned i = 0; i < num_sets; i++)
@@ -75,6 +109,87 @@ Cache *initCache()
     // Initialize Signature Hit Predictor
     cache->shp_table = initSignatureHitPredictor(SHP_TABLE_SIZE);
 
+#ifdef LRU
+    cache->policy = LRU_POLICY;
+#endif
+
+#ifdef LFU
+    cache->policy = LFU_POLICY;
+#endif
+
+#ifdef SHP_REPLACEMENT
+    cache->policy = SHP_POLICY;
+#endif
+
+#ifdef DRRIP
+    cache->policy = DRRIP_POLICY;
+#endif
+
+#ifdef SHIP_PP
+    cache->policy = SHIP_PP_POLICY;
+#endif
+
+#ifdef HAWKEYE
+    cache->policy = HAWKEYE_POLICY;
+#endif
+
+#ifdef OPT
+    cache->policy = OPT_POLICY;
+#endif
+
+    // State of the RRIP-family policies
+    cache->drrip = initDrrip(num_sets);
+    cache->ship_pp = initShipPP();
+    cache->hawkeye = initHawkeye(num_sets, assoc);
+
+    #ifdef PREFETCHING
+    cache->prefetchers = initPrefetchers(&cache->num_prefetchers);
+    cache->demand_misses = 0;
+    cache->pollution_filter = initPollutionFilter();
+    #endif
+
+    #ifdef SHARED_LLC
+    cache->num_cores = num_cores;
+    cache->core_stats = (Core_Stats *)calloc(num_cores, sizeof(Core_Stats));
+
+    cache->partition = NULL;
+    #ifdef STATIC_PARTITION
+    cache->partition = initStaticPartition(num_cores, assoc);
+    #endif
+
+    #ifdef UCP_PARTITION
+    cache->partition = initUCPPartition(num_cores, assoc, num_sets);
+    #endif
+    #endif
+
+    #ifdef VICTIM_CACHE
+    cache->victim_cache = initVictimCache();
+    #endif
+
+    #ifdef MISS_CLASSIFICATION
+    cache->classifier = initMissClassifier(num_blocks);
+    #endif
+
+    #ifdef DEAD_BLOCK_BYPASS
+    cache->dead_block = initDeadBlockPredictor(num_sets);
+    #endif
+
+    #ifdef WRITE_BACK_BUFFER
+    cache->wb_buffer = initWbBuffer();
+    #endif
+
+    #ifdef WAY_PREDICTION
+    cache->way_predictor = initWayPredictor(num_sets, assoc);
+    #endif
+
+    #ifdef PC_STATS
+    cache->pc_stats = initStatsMap();
+    cache->core_access_stats = initStatsMap();
+    #endif
+
+    cache->directory = NULL;
+    cache->owner_core = 0;
+
     return cache;
 }
 
@@ -86,39 +201,220 @@ bool accessBlock(Cache *cache, Request *req, uint64_t access_time)
 
     Cache_Block *blk = findBlock(cache, blk_aligned_addr);
 
+    #ifdef PREFETCHING
+    bool prefetched_hit = false;
+    #endif
+
+    #ifdef WRITE_BACK_BUFFER
+    wbBufferTick(cache->wb_buffer, access_time);
+    if (blk == NULL && wbBufferContains(cache->wb_buffer, blk_aligned_addr))
+    {
+        cache->wb_buffer->read_hits++; // The data is still on its way out, no need to fetch it
+    }
+    #endif
+
+    #ifdef MISS_CLASSIFICATION
+    classifyAccess(cache->classifier, blk_aligned_addr, blk != NULL);
+    #endif
+
+    #ifdef WAY_PREDICTION
+    uint64_t lookup_set = (blk_aligned_addr >> cache->set_shift) & cache->set_mask;
+    wayLookup(cache->way_predictor, lookup_set, req->PC, blk != NULL ? (int)blk->way : -1);
+    #endif
+
+    #ifdef SET_SAMPLING
+    assert(inSampledSet(cache, blk_aligned_addr));
+    uint64_t sampled_set = (blk_aligned_addr >> cache->set_shift) & cache->set_mask;
+    cache->set_accesses[sampled_set]++;
+    cache->set_hits[sampled_set] += blk != NULL;
+    #endif
+
+    #ifdef SHARED_LLC
+    assert(req->core_id >= 0 && req->core_id < cache->num_cores);
+    Core_Stats *core_stats = &cache->core_stats[req->core_id];
+
+    if (cache->partition != NULL)
+    {
+        umonAccess(cache->partition, req->core_id,
+                   (blk_aligned_addr >> cache->set_shift) & cache->set_mask,
+                   blk_aligned_addr >> cache->tag_shift);
+    }
+    #endif
+
+    if (cache->policy == HAWKEYE_POLICY)
+    {
+        hawkeyeAccess(cache->hawkeye,
+                      (blk_aligned_addr >> cache->set_shift) & cache->set_mask,
+                      blk_aligned_addr,
+                      hawkeyeSignature(cache->hawkeye, req->PC, req->core_id));
+    }
+
+    #ifdef DEAD_BLOCK_BYPASS
+    if (cache->policy == SHP_POLICY)
+    {
+        deadBlockAccess(cache->dead_block, (blk_aligned_addr >> cache->set_shift) & cache->set_mask,
+                        blk_aligned_addr >> cache->tag_shift, req->PC);
+    }
+    #endif
+
     if (blk != NULL)
     {
         hit = true;
 
+        #ifdef SHARED_LLC
+        core_stats->hits++;
+        #endif
+
+        #ifdef PREFETCHING
+        if (blk->prefetch)
+        {
+            // First demand hit on a prefetched block
+            Prefetcher_Stats *stats = &cache->prefetchers[blk->prefetcher_id].stats;
+            stats->useful++;
+            if (access_time - blk->prefetch_time < prefetch_latency)
+            {
+                stats->late++;
+            }
+            blk->prefetch = false;
+            prefetched_hit = true;
+        }
+        #endif
+
         // Update access time
         blk->when_touched = access_time;
         // Increment frequency counter
         ++blk->frequency;
 
         blk->rrpv = 0;
+        blk->next_use = req->next_use;
+
+        if (cache->policy == SHIP_PP_POLICY && !blk->outcome && blk->signature != UINT64_MAX)
+        {
+            // SHiP++ trains on the first re-reference only
+            trainShipPP(cache->ship_pp, (uint32_t)blk->signature, true);
+        }
+
+        if (cache->policy == HAWKEYE_POLICY)
+        {
+            hawkeyeHit(cache, blk, req);
+        }
 
         // Set outcome bit to true
         blk->outcome = true;
 
-        if (req->req_type == STORE)
+        if (req->req_type != LOAD)
         {
             blk->dirty = true;
         }
     } 
     else
     {
+        #ifdef SHARED_LLC
+        core_stats->misses++;
+        #endif
+
+        #ifdef PREFETCHING
+        cache->demand_misses++;
+        int culprit = checkPollution(cache->pollution_filter, blk_aligned_addr);
+        if (culprit >= 0)
+        {
+            cache->prefetchers[culprit].stats.pollution++;
+        }
+        #endif
+
+        #ifdef VICTIM_CACHE
+        // Swap: the block comes back from the victim cache and the main victim takes its place
+        bool vc_dirty = false;
+        bool vc_hit = cache->victim_cache != NULL &&
+                      victimCacheLookup(cache->victim_cache, blk_aligned_addr, &vc_dirty);
+        #endif
+
         // Cache miss, need to insert the block
         uint64_t wb_addr;
-        bool wb_required = insertBlock(cache, req, access_time, &wb_addr);
+        bool wb_required = false;
+        bool bypass = false;
+
+        #ifdef DEAD_BLOCK_BYPASS
+        // Skip allocation when the block looks dead on arrival; a bypassed store goes straight to memory.
+        // Private caches always fill, since the directory already counts them as sharers.
+        if (cache->policy == SHP_POLICY && cache->directory == NULL && predictDead(cache->dead_block, req->PC))
+        {
+            bypass = true;
+            #ifdef VICTIM_CACHE
+            bypass = !vc_hit;
+            #endif
+        }
+
+        if (bypass)
+        {
+            cache->dead_block->bypasses++;
+            if (req->req_type != LOAD)
+            {
+                cache->dead_block->bypassed_writes++;
+                wb_required = true;
+                wb_addr = blk_aligned_addr;
+            }
+        }
+        #endif
+
+        if (!bypass)
+        {
+            wb_required = insertBlock(cache, req, access_time, &wb_addr);
+        }
+
+        #ifdef VICTIM_CACHE
+        if (vc_hit && vc_dirty)
+        {
+            findBlock(cache, blk_aligned_addr)->dirty = true;
+        }
+        #endif
 
         // Handle write-back if necessary
         if (wb_required)
         {
-            // Write back dirty block to lower level (implement this function)
-            cache->write_back_count++;
+            // Write back dirty block to lower level
+            writeBack(cache, wb_addr, access_time);
+
+            #ifdef PC_STATS
+            statsEntry(cache->pc_stats, req->PC)->write_backs++;
+            statsEntry(cache->core_access_stats, req->core_id)->write_backs++;
+            #endif
         }
     }
 
+    #ifdef WAY_PREDICTION
+    Cache_Block *resident = hit ? blk : findBlock(cache, blk_aligned_addr);
+    if (resident != NULL)
+    {
+        trainWayPredictor(cache->way_predictor, lookup_set, req->PC, resident->way);
+    }
+    #endif
+
+    #ifdef PC_STATS
+    Access_Stats *pc_stats = statsEntry(cache->pc_stats, req->PC);
+    pc_stats->accesses++;
+    pc_stats->misses += !hit;
+
+    Access_Stats *core_access_stats = statsEntry(cache->core_access_stats, req->core_id);
+    core_access_stats->accesses++;
+    core_access_stats->misses += !hit;
+    #endif
+
+    #ifdef SHARED_LLC
+    for (unsigned i = 0; i < cache->num_cores; i++)
+    {
+        cache->core_stats[i].occupancy_sum += cache->core_stats[i].occupancy;
+    }
+    #endif
+
+    #ifdef PREFETCHING
+    issuePrefetches(cache, req, blk_aligned_addr, access_time, !hit || prefetched_hit);
+    #endif
+
+    #ifdef EAGER_WRITE_BACK
+    eagerWriteBack(cache, (blk_aligned_addr >> cache->set_shift) & cache->set_mask, access_time);
+    #endif
+
     return hit;
 }
 
@@ -128,20 +424,46 @@ bool insertBlock(Cache *cache, Request *req, uint64_t access_time, uint64_t *wb_
     uint64_t blk_aligned_addr = blkAlign(req->load_or_store_addr, cache->blk_mask);
 
     Cache_Block *victim = NULL;
-#ifdef LRU
-    bool wb_required = lru(cache, blk_aligned_addr, &victim, wb_addr);
-#endif
-
-#ifdef LFU
-    bool wb_required = lfu(cache, blk_aligned_addr, &victim, wb_addr);
-#endif
-
-#ifdef SHP_REPLACEMENT
-    bool wb_required = signature_hit_predictor(cache, blk_aligned_addr, &victim, wb_addr, req->PC);
-#endif
+    bool wb_required = false;
+    switch (cache->policy)
+    {
+        case LRU_POLICY:
+            wb_required = lru(cache, blk_aligned_addr, &victim, wb_addr, req);
+            break;
+        case LFU_POLICY:
+            wb_required = lfu(cache, blk_aligned_addr, &victim, wb_addr, req);
+            break;
+        case SHP_POLICY:
+            wb_required = signature_hit_predictor(cache, blk_aligned_addr, &victim, wb_addr, req);
+            break;
+        case DRRIP_POLICY:
+            wb_required = drrip(cache, blk_aligned_addr, &victim, wb_addr, req);
+            break;
+        case SHIP_PP_POLICY:
+            wb_required = ship_pp(cache, blk_aligned_addr, &victim, wb_addr, req);
+            break;
+        case HAWKEYE_POLICY:
+            wb_required = hawkeye(cache, blk_aligned_addr, &victim, wb_addr, req);
+            break;
+        case OPT_POLICY:
+            wb_required = opt(cache, blk_aligned_addr, &victim, wb_addr, req);
+            break;
+        default:
+            assert(false);
+    }
 
     assert(victim != NULL);
 
+    #ifdef VICTIM_CACHE
+    // Dirty blocks are written back when they leave the victim cache, not the main cache
+    if (cache->victim_cache != NULL)
+    {
+        wb_required = cache->victim_cache->wb_pending;
+        *wb_addr = cache->victim_cache->wb_addr;
+        cache->victim_cache->wb_pending = false;
+    }
+    #endif
+
     // Step two: insert the new block
     uint64_t tag = req->load_or_store_addr >> cache->tag_shift;
     victim->tag = tag;
@@ -150,7 +472,19 @@ bool insertBlock(Cache *cache, Request *req, uint64_t access_time, uint64_t *wb_
     victim->when_touched = access_time;
     ++victim->frequency;
 
-    if (req->req_type == STORE)
+    victim->PC = req->PC;
+    victim->core_id = req->core_id;
+    victim->next_use = req->next_use;
+
+    victim->prefetch = req->prefetcher_id >= 0;
+    victim->prefetcher_id = req->prefetcher_id;
+    victim->prefetch_time = access_time;
+
+    #ifdef SHARED_LLC
+    cache->core_stats[req->core_id].occupancy++;
+    #endif
+
+    if (req->req_type != LOAD)
     {
         victim->dirty = true;
     }
@@ -189,7 +523,280 @@ Cache_Block *findBlock(Cache *cache, uint64_t addr)
     return NULL;
 }
 
-bool lru(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr)
+// Does addr map to a set this cache models? Always true without SET_SAMPLING.
+bool inSampledSet(Cache *cache, uint64_t addr)
+{
+    #ifdef SET_SAMPLING
+    return (addr & cache->sample_mask) == 0;
+    #else
+    return true;
+    #endif
+}
+
+// Book-keeping for a valid block that is about to be replaced by req's block.
+void evictBlock(Cache *cache, Cache_Block *victim, Request *req)
+{
+    #if defined(VICTIM_CACHE) || defined(PREFETCHING) || defined(COHERENCE)
+    uint64_t victim_addr = (victim->tag << cache->tag_shift) | (victim->set << cache->set_shift);
+    #endif
+
+    #ifdef SHARED_LLC
+    if (victim->core_id >= 0)
+    {
+        Core_Stats *owner = &cache->core_stats[victim->core_id];
+        owner->occupancy--;
+        owner->evictions++;
+
+        if (victim->core_id != req->core_id)
+        {
+            owner->evicted_by_others++;
+        }
+    }
+    #endif
+
+    #ifdef PREFETCHING
+    if (victim->prefetch)
+    {
+        cache->prefetchers[victim->prefetcher_id].stats.useless++;
+    }
+    else if (req->prefetcher_id >= 0)
+    {
+        // A demanded block made room for a prefetch
+        recordPollution(cache->pollution_filter, victim_addr, req->prefetcher_id);
+    }
+    #endif
+
+    #ifdef PC_STATS
+    statsEntry(cache->pc_stats, req->PC)->evictions++;
+    statsEntry(cache->core_access_stats, req->core_id)->evictions++;
+    #endif
+
+    #ifdef VICTIM_CACHE
+    if (cache->victim_cache != NULL)
+    {
+        victimCacheFill(cache->victim_cache, victim_addr, victim->dirty);
+    }
+    #endif
+
+    #ifdef COHERENCE
+    if (cache->directory != NULL)
+    {
+        directoryEvict(cache->directory, cache->owner_core, victim_addr);
+    }
+    #endif
+
+    victim->core_id = -1;
+    victim->prefetch = false;
+}
+
+// Send a dirty block to the next level
+void writeBack(Cache *cache, uint64_t wb_addr, uint64_t access_time)
+{
+    cache->write_back_count++;
+
+    #ifdef WRITE_BACK_BUFFER
+    wbBufferInsert(cache->wb_buffer, wb_addr, access_time);
+    #endif
+}
+
+// While the write-back buffer is idle, clean the least recently touched dirty block of a full set,
+// which is likely the next victim
+void eagerWriteBack(Cache *cache, uint64_t set_idx, uint64_t access_time)
+{
+    #ifdef WRITE_BACK_BUFFER
+    if (cache->wb_buffer->occupancy > 0)
+    {
+        return;
+    }
+
+    Cache_Block **ways = cache->sets[set_idx].ways;
+    Cache_Block *oldest = NULL;
+    for (unsigned i = 0; i < cache->num_ways; i++)
+    {
+        if (!ways[i]->valid)
+        {
+            return; // The next fill will not evict anything
+        }
+
+        if (oldest == NULL || ways[i]->when_touched < oldest->when_touched)
+        {
+            oldest = ways[i];
+        }
+    }
+
+    if (oldest->dirty)
+    {
+        oldest->dirty = false;
+        cache->wb_buffer->eager++;
+        wbBufferInsert(cache->wb_buffer, (oldest->tag << cache->tag_shift) | (set_idx << cache->set_shift),
+                       access_time);
+    }
+    #endif
+}
+
+// Ask every prefetcher for candidates after a demand access and fill the ones not yet cached.
+void issuePrefetches(Cache *cache, Request *req, uint64_t blk_addr, uint64_t access_time, bool trigger)
+{
+    #ifdef PREFETCHING
+    #ifdef COHERENCE
+    if (cache->directory != NULL)
+    {
+        return; // Prefetches into private caches would bypass the directory
+    }
+    #endif
+
+    unsigned blk_shift = (unsigned)log2(cache->blk_mask + 1);
+    uint64_t page = blk_addr >> 12;
+
+    for (unsigned p = 0; p < cache->num_prefetchers; p++)
+    {
+        Prefetcher *prefetcher = &cache->prefetchers[p];
+
+        // The stride prefetcher trains on every access, the rest on misses and prefetch hits
+        if (!trigger && prefetcher->type != STRIDE)
+        {
+            continue;
+        }
+
+        uint64_t candidates[MAX_PREFETCH_DEGREE];
+        unsigned n = prefetcherOperate(prefetcher, req, blk_addr, blk_shift, candidates);
+
+        for (unsigned i = 0; i < n; i++)
+        {
+            // Stay within the 4KB page, like a hardware prefetcher without translation
+            if ((candidates[i] >> 12) != page || !inSampledSet(cache, candidates[i]) ||
+                findBlock(cache, candidates[i]) != NULL)
+            {
+                continue;
+            }
+
+            Request pf_req = *req;
+            pf_req.req_type = LOAD;
+            pf_req.load_or_store_addr = candidates[i];
+            pf_req.next_use = UINT64_MAX;
+            pf_req.prefetcher_id = (int)p;
+            pf_req.has_data = false;
+
+            uint64_t wb_addr;
+            if (insertBlock(cache, &pf_req, access_time, &wb_addr))
+            {
+                writeBack(cache, wb_addr, access_time);
+            }
+
+            prefetcher->stats.issued++;
+            prefetchFilled(prefetcher, candidates[i], blk_shift);
+        }
+    }
+    #endif
+}
+
+// Drop addr from the cache without a replacement, returning whether the copy was dirty
+bool invalidateBlock(Cache *cache, uint64_t addr)
+{
+    Cache_Block *blk = findBlock(cache, addr);
+    if (blk == NULL)
+    {
+        return false;
+    }
+
+    bool dirty = blk->dirty;
+
+    #ifdef SHARED_LLC
+    if (blk->core_id >= 0)
+    {
+        cache->core_stats[blk->core_id].occupancy--;
+    }
+    #endif
+
+    blk->tag = UINT64_MAX;
+    blk->valid = false;
+    blk->dirty = false;
+    blk->frequency = 0;
+    blk->when_touched = 0;
+    blk->core_id = -1;
+    blk->prefetch = false;
+
+    return dirty;
+}
+
+// Evict victim for req and reset it, returning whether it has to be written back
+bool replaceBlock(Cache *cache, Cache_Block *victim, uint64_t *wb_addr, Request *req)
+{
+    bool wb_required = victim->dirty;
+
+    if (wb_required)
+    {
+        *wb_addr = (victim->tag << cache->tag_shift) | (victim->set << cache->set_shift);
+    }
+
+    evictBlock(cache, victim, req);
+
+    // Invalidate victim
+    victim->tag = UINT64_MAX;
+    victim->valid = false;
+    victim->dirty = false;
+    victim->frequency = 0;
+    victim->when_touched = 0;
+
+    return wb_required;
+}
+
+// Bitmask of the ways req is allowed to evict within a full set.
+uint64_t victimCandidates(Cache *cache, Cache_Block **ways, Request *req)
+{
+    assert(cache->num_ways <= 64);
+    uint64_t all_ways = cache->num_ways == 64 ? UINT64_MAX : ((uint64_t)1 << cache->num_ways) - 1;
+
+    #ifdef SHARED_LLC
+    Partition *partition = cache->partition;
+    if (partition == NULL)
+    {
+        return all_ways;
+    }
+
+    // Count how many ways every core holds in this set
+    unsigned owned[64] = {0};
+    assert(cache->num_cores <= 64);
+    for (unsigned i = 0; i < cache->num_ways; i++)
+    {
+        if (ways[i]->valid && ways[i]->core_id >= 0)
+        {
+            owned[ways[i]->core_id]++;
+        }
+    }
+
+    uint64_t candidates = 0;
+    if (owned[req->core_id] < partition->quota[req->core_id])
+    {
+        // Below quota: take a way from a core that is over its quota
+        for (unsigned i = 0; i < cache->num_ways; i++)
+        {
+            int owner = ways[i]->core_id;
+            if (owner >= 0 && owned[owner] > partition->quota[owner])
+            {
+                candidates |= (uint64_t)1 << i;
+            }
+        }
+    }
+    else
+    {
+        // At or above quota: replace one of our own blocks
+        for (unsigned i = 0; i < cache->num_ways; i++)
+        {
+            if (ways[i]->core_id == req->core_id)
+            {
+                candidates |= (uint64_t)1 << i;
+            }
+        }
+    }
+
+    return candidates != 0 ? candidates : all_ways;
+    #else
+    return all_ways;
+    #endif
+}
+
+bool lru(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, Request *req)
 {
     uint64_t set_idx = (addr >> cache->set_shift) & cache->set_mask;
     // printf("Set: %" PRIu64 "\n", set_idx);
@@ -205,11 +812,18 @@ bool lru(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_add
         }
     }
 
-    // Step two: locate the LRU block
-    Cache_Block *victim = ways[0];
-    for (unsigned i = 1; i < cache->num_ways; i++)
+    // Step two: locate the LRU block among the ways we may evict
+    uint64_t candidates = victimCandidates(cache, ways, req);
+
+    Cache_Block *victim = NULL;
+    for (unsigned i = 0; i < cache->num_ways; i++)
     {
-        if (ways[i]->when_touched < victim->when_touched)
+        if (!((candidates >> i) & 1))
+        {
+            continue;
+        }
+
+        if (victim == NULL || ways[i]->when_touched < victim->when_touched)
         {
             victim = ways[i];
         }
@@ -223,6 +837,8 @@ bool lru(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_add
         *wb_addr = (victim->tag << cache->tag_shift) | (victim->set << cache->set_shift);
     }
 
+    evictBlock(cache, victim, req);
+
     // Invalidate victim
     victim->tag = UINT64_MAX;
     victim->valid = false;
@@ -235,7 +851,7 @@ bool lru(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_add
     return wb_required; // Need to write-back if dirty
 }
 
-bool lfu(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr)
+bool lfu(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, Request *req)
 {
     uint64_t set_idx = (addr >> cache->set_shift) & cache->set_mask;
     // printf("Set: %" PRIu64 "\n", set_idx);
@@ -252,10 +868,21 @@ bool lfu(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_add
     }
 
     // Step two: locate the LFU block with the oldest timestamp in case of frequency tie
-    Cache_Block *victim = ways[0];
-    for (unsigned i = 1; i < cache->num_ways; i++)
+    uint64_t candidates = victimCandidates(cache, ways, req);
+
+    Cache_Block *victim = NULL;
+    for (unsigned i = 0; i < cache->num_ways; i++)
     {
-        if (ways[i]->frequency < victim->frequency)
+        if (!((candidates >> i) & 1))
+        {
+            continue;
+        }
+
+        if (victim == NULL)
+        {
+            victim = ways[i];
+        }
+        else if (ways[i]->frequency < victim->frequency)
         {
             victim = ways[i];
         }
@@ -276,6 +903,8 @@ bool lfu(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_add
         *wb_addr = (victim->tag << cache->tag_shift) | (victim->set << cache->set_shift);
     }
 
+    evictBlock(cache, victim, req);
+
     // Invalidate victim
     victim->tag = UINT64_MAX;
     victim->valid = false;
@@ -288,6 +917,62 @@ bool lfu(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_add
     return wb_required; // Need to write-back if dirty
 }
 
+// Belady's OPT: evict the block whose next reference is furthest in the future
+bool opt(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, Request *req)
+{
+    uint64_t set_idx = (addr >> cache->set_shift) & cache->set_mask;
+    Cache_Block **ways = cache->sets[set_idx].ways;
+
+    // Step one: try to find an invalid block.
+    for (unsigned i = 0; i < cache->num_ways; i++)
+    {
+        if (ways[i]->valid == false)
+        {
+            *victim_blk = ways[i];
+            return false; // No need to write-back
+        }
+    }
+
+    // Step two: locate the block reused furthest in the future
+    uint64_t candidates = victimCandidates(cache, ways, req);
+
+    Cache_Block *victim = NULL;
+    for (unsigned i = 0; i < cache->num_ways; i++)
+    {
+        if (!((candidates >> i) & 1))
+        {
+            continue;
+        }
+
+        if (victim == NULL || ways[i]->next_use > victim->next_use)
+        {
+            victim = ways[i];
+        }
+    }
+
+    // Step three: need to write-back the victim block if dirty
+    bool wb_required = replaceBlock(cache, victim, wb_addr, req);
+
+    *victim_blk = victim;
+
+    return wb_required; // Need to write-back if dirty
+}
+
+const char *policyName(Replacement_Policy policy)
+{
+    switch (policy)
+    {
+        case LRU_POLICY: return "LRU";
+        case LFU_POLICY: return "LFU";
+        case SHP_POLICY: return "SHP";
+        case DRRIP_POLICY: return "DRRIP";
+        case SHIP_PP_POLICY: return "SHiP++";
+        case HAWKEYE_POLICY: return "Hawkeye";
+        case OPT_POLICY: return "OPT";
+        default: return "?";
+    }
+}
+
 /* Signature Hit Predictor Implementation */
 
 
@@ -342,8 +1027,9 @@ void updateSignatureHitPredictor(SignatureHitPredictor *shp, uint64_t signature,
 }
 
 // Signature Hit Predictor Replacement Policy
-bool signature_hit_predictor(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, uint64_t signature)
+bool signature_hit_predictor(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, Request *req)
 {
+    uint64_t signature = req->PC;
     SignatureHitPredictor *shp = cache->shp_table;
     uint8_t max_rrpv = cache->max_rrpv; // e.g., 3 for 2-bit RRPV
 
@@ -390,14 +1076,16 @@ bool signature_hit_predictor(Cache *cache, uint64_t addr, Cache_Block **victim_b
     }
 
     // Step two: find a victim with RRPV == max_rrpv
+    uint64_t candidates = victimCandidates(cache, ways, req);
     while (true)
     {
         for (unsigned i = 0; i < cache->num_ways; i++)
         {
-            if (ways[i]->rrpv == max_rrpv)
+            if (((candidates >> i) & 1) && ways[i]->rrpv == max_rrpv)
             {
                 // Victim found
                 Cache_Block *victim = ways[i];
+                evictBlock(cache, victim, req);
 
                 // Update predictor based on outcome
                 updateSignatureHitPredictor(shp, victim->signature, victim->outcome);
@@ -424,10 +1112,10 @@ bool signature_hit_predictor(Cache *cache, uint64_t addr, Cache_Block **victim_b
             }
         }
 
-        // Increment RRPV of all blocks
+        // Increment RRPV of all blocks we may evict
         for (unsigned i = 0; i < cache->num_ways; i++)
         {
-            if (ways[i]->rrpv < max_rrpv)
+            if (((candidates >> i) & 1) && ways[i]->rrpv < max_rrpv)
                 ways[i]->rrpv++;
         }
     }
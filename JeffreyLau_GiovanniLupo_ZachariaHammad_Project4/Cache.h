@@ -9,14 +9,47 @@
 
 #include "Cache_Blk.h"
 #include "Request.h"
+#include "Partition.h"
+#include "Rrip.h"
+#include "Prefetcher.h"
+#include "Victim_Cache.h"
+#include "Dead_Block.h"
+#include "Pc_Stats.h"
+#include "Wb_Buffer.h"
+#include "Way_Predictor.h"
 
 // Uncomment the replacement policy you want to use
 //#define LRU
 //#define LFU
 #define SHP_REPLACEMENT
+//#define DRRIP
+//#define SHIP_PP
+//#define HAWKEYE
+//#define OPT
+
+// Uncomment to simulate every online policy next to Belady's OPT and report the gap
+//#define OPT_STUDY
+
+// Uncomment to model a shared LLC with per-core statistics
+//#define SHARED_LLC
+// Way-partitioning policy for the shared LLC (requires SHARED_LLC)
+//#define STATIC_PARTITION
+//#define UCP_PARTITION
+
+// Uncomment to also run every request through per-core private caches kept coherent by a MESI directory
+//#define COHERENCE
+
+// Uncomment to model only a subset of the sets and extrapolate the statistics
+//#define SET_SAMPLING
+
+// Uncomment to estimate performance with hit/miss latencies and a bounded MSHR file
+//#define TIMING_MODEL
 
 #define MAX_PREDICTOR_COUNTER 3
 
+typedef enum Replacement_Policy{LRU_POLICY, LFU_POLICY, SHP_POLICY, DRRIP_POLICY, SHIP_PP_POLICY,
+                                HAWKEYE_POLICY, OPT_POLICY, NUM_POLICIES}Replacement_Policy;
+
 /* Cache */
 typedef struct Set
 {
@@ -53,12 +86,66 @@ typedef struct Cache
 
     Set *sets; // All the sets of a cache
 
+    #ifdef SET_SAMPLING
+    unsigned sample_shift; // One out of (1 << sample_shift) sets is modeled
+    uint64_t sample_mask; // Address bits that must be zero for a modeled set
+    uint64_t *set_accesses; // Per modeled set, for the confidence interval
+    uint64_t *set_hits;
+    #endif
+
+    Replacement_Policy policy; // Defaults to the policy selected above
+
     /* Signature Hit Predictor */
     SignatureHitPredictor *shp_table;
 
     unsigned max_rrpv;
     uint64_t write_back_count;
 
+    /* RRIP-family policies */
+    Drrip *drrip;
+    Ship_PP *ship_pp;
+    Hawkeye *hawkeye;
+
+    #ifdef PREFETCHING
+    Prefetcher *prefetchers;
+    unsigned num_prefetchers;
+    uint64_t demand_misses;
+    Pollution_Filter *pollution_filter;
+    #endif
+
+    #ifdef SHARED_LLC
+    unsigned num_cores;
+    Core_Stats *core_stats; // Per-core hits, misses and occupancy
+    Partition *partition; // Way quotas, NULL if the LLC is unpartitioned
+    #endif
+
+    #ifdef VICTIM_CACHE
+    Victim_Cache *victim_cache; // NULL on caches that run without one
+    #endif
+
+    #ifdef MISS_CLASSIFICATION
+    Miss_Classifier *classifier;
+    #endif
+
+    #ifdef DEAD_BLOCK_BYPASS
+    Dead_Block_Predictor *dead_block; // Consulted by SHP on every miss
+    #endif
+
+    #ifdef WRITE_BACK_BUFFER
+    Wb_Buffer *wb_buffer;
+    #endif
+
+    #ifdef WAY_PREDICTION
+    Way_Predictor *way_predictor;
+    #endif
+
+    #ifdef PC_STATS
+    Stats_Map *pc_stats;
+    Stats_Map *core_access_stats;
+    #endif
+
+    struct Directory *directory; // Set on the private caches of the coherence model, NULL otherwise
+    unsigned owner_core;
 } Cache;
 
 // Function Definitions
@@ -70,11 +157,26 @@ void freeCache(Cache *cache);
 // Helper Functions
 uint64_t blkAlign(uint64_t addr, uint64_t mask);
 Cache_Block *findBlock(Cache *cache, uint64_t addr);
+bool inSampledSet(Cache *cache, uint64_t addr);
+void evictBlock(Cache *cache, Cache_Block *victim, Request *req);
+void writeBack(Cache *cache, uint64_t wb_addr, uint64_t access_time);
+void eagerWriteBack(Cache *cache, uint64_t set_idx, uint64_t access_time);
+bool invalidateBlock(Cache *cache, uint64_t addr);
+bool replaceBlock(Cache *cache, Cache_Block *victim, uint64_t *wb_addr, Request *req);
+uint64_t victimCandidates(Cache *cache, Cache_Block **ways, Request *req);
+void issuePrefetches(Cache *cache, Request *req, uint64_t blk_addr, uint64_t access_time, bool trigger);
 
 // Replacement Policies
-bool lru(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr);
-bool lfu(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr);
-bool signature_hit_predictor(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, uint64_t signature);
+bool lru(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, Request *req);
+bool lfu(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, Request *req);
+bool signature_hit_predictor(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, Request *req);
+bool drrip(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, Request *req);
+bool ship_pp(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, Request *req);
+bool hawkeye(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, Request *req);
+bool opt(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, Request *req);
+Cache_Block *rripVictim(Cache *cache, Cache_Block **ways, uint64_t candidates, uint8_t max_rrpv);
+void hawkeyeHit(Cache *cache, Cache_Block *blk, Request *req);
+const char *policyName(Replacement_Policy policy);
 
 /* Signature Hit Predictor Function Declarations */
 SignatureHitPredictor *initSignatureHitPredictor(unsigned table_size);
@@ -15,6 +15,7 @@ typedef struct Cache_Block
 
     uint64_t when_touched; // The last time this block is referenced.
     uint64_t frequency; // How many times this block is referenced.
+    uint64_t next_use; // When this block is referenced next (OPT only).
 
     uint32_t set; // Which set this block belongs to?
     uint32_t way; // Which way (within this set) belongs to?
@@ -22,6 +23,10 @@ typedef struct Cache_Block
     uint64_t signature;
     uint8_t rrpv;
     bool outcome;
+
+    bool prefetch; // Brought in by a prefetch and not yet demanded?
+    int prefetcher_id; // Which prefetcher brought it in
+    uint64_t prefetch_time; // When the prefetch was issued
     // Advanced Features
     uint64_t PC; // Which instruction that brings in this block?
     int core_id; // Which core the instruction is running on.
@@ -0,0 +1,271 @@
+#include "Coherence.h"
+
+extern const unsigned num_cores;
+
+/* Constants */
+const unsigned coherence_word_size = 8; // False sharing is tracked per 8-byte word
+const unsigned physical_addr_bits = 48; // For the directory tag width
+
+uint64_t hashDirectoryBlock(uint64_t blk_addr)
+{
+    blk_addr ^= blk_addr >> 31;
+    blk_addr *= 0x9e3779b97f4a7c15ULL;
+    blk_addr ^= blk_addr >> 29;
+    return blk_addr;
+}
+
+Directory *initDirectory()
+{
+    Directory *directory = (Directory *)calloc(1, sizeof(Directory));
+    directory->capacity = 1024;
+    directory->entries = (Directory_Entry *)malloc(directory->capacity * sizeof(Directory_Entry));
+    for (uint64_t i = 0; i < directory->capacity; i++)
+    {
+        directory->entries[i].blk_addr = UINT64_MAX;
+    }
+    return directory;
+}
+
+Directory_Entry *findDirectoryEntry(Directory *directory, uint64_t blk_addr)
+{
+    uint64_t mask = directory->capacity - 1;
+    uint64_t slot = hashDirectoryBlock(blk_addr) & mask;
+
+    while (directory->entries[slot].blk_addr != UINT64_MAX &&
+           directory->entries[slot].blk_addr != blk_addr)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return &directory->entries[slot];
+}
+
+void growDirectory(Directory *directory)
+{
+    Directory_Entry *old_entries = directory->entries;
+    uint64_t old_capacity = directory->capacity;
+
+    directory->capacity *= 2;
+    directory->entries = (Directory_Entry *)malloc(directory->capacity * sizeof(Directory_Entry));
+    for (uint64_t i = 0; i < directory->capacity; i++)
+    {
+        directory->entries[i].blk_addr = UINT64_MAX;
+    }
+
+    for (uint64_t i = 0; i < old_capacity; i++)
+    {
+        if (old_entries[i].blk_addr != UINT64_MAX)
+        {
+            *findDirectoryEntry(directory, old_entries[i].blk_addr) = old_entries[i];
+        }
+    }
+
+    free(old_entries);
+}
+
+// Entry of blk_addr, created in state I on the first reference
+Directory_Entry *directoryEntry(Directory *directory, uint64_t blk_addr)
+{
+    Directory_Entry *entry = findDirectoryEntry(directory, blk_addr);
+    if (entry->blk_addr == blk_addr)
+    {
+        return entry;
+    }
+
+    if (2 * (directory->size + 1) > directory->capacity)
+    {
+        growDirectory(directory);
+        entry = findDirectoryEntry(directory, blk_addr);
+    }
+
+    memset(entry, 0, sizeof(Directory_Entry));
+    entry->blk_addr = blk_addr;
+    entry->state = MESI_I;
+    directory->size++;
+
+    return entry;
+}
+
+// A private cache replaced its copy of blk_addr
+void directoryEvict(Directory *directory, unsigned core, uint64_t blk_addr)
+{
+    Directory_Entry *entry = findDirectoryEntry(directory, blk_addr);
+    assert(entry->blk_addr == blk_addr && ((entry->sharers >> core) & 1));
+
+    entry->sharers &= ~((uint64_t)1 << core);
+    if (entry->sharers == 0)
+    {
+        entry->state = MESI_I;
+        directory->active_entries--;
+    }
+}
+
+Coherence *initCoherence()
+{
+    assert(num_cores <= MAX_COHERENT_CORES);
+
+    Coherence *coherence = (Coherence *)calloc(1, sizeof(Coherence));
+    coherence->num_cores = num_cores;
+    coherence->directory = initDirectory();
+
+    coherence->caches = (Cache **)malloc(num_cores * sizeof(Cache *));
+    for (unsigned i = 0; i < num_cores; i++)
+    {
+        Cache *cache = initCache();
+        cache->directory = coherence->directory;
+        cache->owner_core = i;
+
+        #ifdef VICTIM_CACHE
+        cache->victim_cache = NULL; // Copies parked there would escape invalidation
+        #endif
+
+        coherence->caches[i] = cache;
+    }
+
+    coherence->blk_shift = (unsigned)log2(coherence->caches[0]->blk_mask + 1);
+    coherence->word_shift = (unsigned)log2(coherence_word_size);
+    assert(coherence->blk_shift - coherence->word_shift <= 6); // Word masks are 64 bits wide
+
+    return coherence;
+}
+
+// Remove every copy in others because core is about to write the block
+void invalidateSharers(Coherence *coherence, Directory_Entry *entry, uint64_t others)
+{
+    for (unsigned i = 0; i < coherence->num_cores; i++)
+    {
+        if ((others >> i) & 1)
+        {
+            invalidateBlock(coherence->caches[i], entry->blk_addr);
+            coherence->stats.invalidations++;
+        }
+    }
+
+    entry->invalidated |= others;
+}
+
+bool coherentAccess(Coherence *coherence, Request *req, uint64_t access_time)
+{
+    assert(req->core_id >= 0 && (unsigned)req->core_id < coherence->num_cores);
+
+    Directory *directory = coherence->directory;
+    Coherence_Stats *stats = &coherence->stats;
+
+    unsigned core = req->core_id;
+    uint64_t core_bit = (uint64_t)1 << core;
+    uint64_t blk_addr = req->load_or_store_addr >> coherence->blk_shift << coherence->blk_shift;
+    unsigned word = (unsigned)((req->load_or_store_addr - blk_addr) >> coherence->word_shift);
+    uint64_t word_bit = (uint64_t)1 << word;
+
+    Directory_Entry *entry = directoryEntry(directory, blk_addr);
+    bool present = entry->sharers & core_bit;
+    uint64_t others = entry->sharers & ~core_bit;
+
+    // Step one: was our copy lost to a remote write?
+    if (!present && (entry->invalidated & core_bit))
+    {
+        stats->coherence_misses++;
+        if (entry->remote_written[core] & word_bit)
+        {
+            stats->true_sharing++;
+        }
+        else
+        {
+            stats->false_sharing++; // Only other words of the block changed hands
+        }
+    }
+    entry->invalidated &= ~core_bit;
+    entry->remote_written[core] = 0;
+
+    if (entry->sharers == 0)
+    {
+        if (++directory->active_entries > directory->peak_active_entries)
+        {
+            directory->peak_active_entries = directory->active_entries;
+        }
+    }
+
+    // Step two: MESI transition at the directory
+    if (req->req_type != LOAD)
+    {
+        if (present && entry->state == MESI_S)
+        {
+            stats->upgrades++;
+        }
+        else if (!present && (entry->state == MESI_E || entry->state == MESI_M))
+        {
+            stats->interventions++; // The owner forwards the block and invalidates its copy
+        }
+
+        if (others != 0)
+        {
+            invalidateSharers(coherence, entry, others);
+        }
+
+        // Remember what we wrote for every core that lost its copy
+        for (unsigned i = 0; i < coherence->num_cores; i++)
+        {
+            if (i != core && ((entry->invalidated >> i) & 1))
+            {
+                entry->remote_written[i] |= word_bit;
+            }
+        }
+
+        entry->sharers = core_bit;
+        entry->state = MESI_M;
+    }
+    else if (!present)
+    {
+        if (others != 0 && (entry->state == MESI_E || entry->state == MESI_M))
+        {
+            // Downgrade the owner to S, writing its data back if modified
+            stats->interventions++;
+            if (entry->state == MESI_M)
+            {
+                stats->write_backs++;
+            }
+
+            for (unsigned i = 0; i < coherence->num_cores; i++)
+            {
+                if ((others >> i) & 1)
+                {
+                    Cache_Block *blk = findBlock(coherence->caches[i], blk_addr);
+                    assert(blk != NULL);
+                    blk->dirty = false;
+                }
+            }
+        }
+
+        entry->state = others != 0 ? MESI_S : MESI_E;
+        entry->sharers |= core_bit;
+    }
+
+    // Step three: the private cache itself
+    bool hit = accessBlock(coherence->caches[core], req, access_time);
+    assert(hit == present);
+
+    if (hit)
+    {
+        stats->hits++;
+    }
+    else
+    {
+        stats->misses++;
+    }
+
+    return hit;
+}
+
+// Sparse full-map directory with one entry per private block: tag, sharer vector and state
+double directoryStorageKB(Coherence *coherence)
+{
+    Cache *cache = coherence->caches[0];
+    uint64_t entries = (uint64_t)cache->num_blocks * coherence->num_cores;
+    #ifdef SET_SAMPLING
+    entries <<= cache->sample_shift;
+    #endif
+    unsigned tag_bits = physical_addr_bits - coherence->blk_shift;
+    unsigned entry_bits = tag_bits + coherence->num_cores + 2;
+
+    return (double)(entries * entry_bits) / 8.0 / 1024.0;
+}
@@ -0,0 +1,72 @@
+#ifndef __COHERENCE_H__
+#define __COHERENCE_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Cache.h"
+
+#define MAX_COHERENT_CORES 16
+
+typedef enum MESI_State{MESI_I, MESI_S, MESI_E, MESI_M}MESI_State;
+
+/* Full-map directory entry, one per block ever referenced */
+typedef struct Directory_Entry
+{
+    uint64_t blk_addr; // UINT64_MAX marks an empty slot
+    uint64_t sharers; // One bit per core holding a copy
+    MESI_State state; // State of the copies (E and M imply a single sharer)
+
+    // False-sharing detection
+    uint64_t invalidated; // Cores whose copy was invalidated by a remote write
+    uint64_t remote_written[MAX_COHERENT_CORES]; // Words written by others since that invalidation
+} Directory_Entry;
+
+typedef struct Directory
+{
+    Directory_Entry *entries; // Open-addressing map
+    uint64_t capacity;
+    uint64_t size;
+
+    uint64_t active_entries; // Blocks cached by at least one core
+    uint64_t peak_active_entries;
+} Directory;
+
+typedef struct Coherence_Stats
+{
+    uint64_t hits;
+    uint64_t misses;
+
+    uint64_t invalidations; // Copies invalidated by a remote write
+    uint64_t upgrades; // Writes to a block held in S
+    uint64_t interventions; // Requests served by a core holding the block in E or M
+    uint64_t write_backs; // M copies written back on a downgrade
+
+    uint64_t coherence_misses; // Misses on a copy that a remote write invalidated
+    uint64_t true_sharing; // ... where the missing word was actually written remotely
+    uint64_t false_sharing; // ... where only other words of the block were
+} Coherence_Stats;
+
+typedef struct Coherence
+{
+    unsigned num_cores;
+    Cache **caches; // Private cache per core
+    Directory *directory;
+
+    unsigned blk_shift;
+    unsigned word_shift; // Granularity of the false-sharing masks
+
+    Coherence_Stats stats;
+} Coherence;
+
+// Function Definitions
+Coherence *initCoherence();
+bool coherentAccess(Coherence *coherence, Request *req, uint64_t access_time);
+void directoryEvict(Directory *directory, unsigned core, uint64_t blk_addr);
+double directoryStorageKB(Coherence *coherence);
+
+#endif /* __COHERENCE_H__ */
@@ -0,0 +1,293 @@
+#include "Compression.h"
+
+/* Constants */
+// BDI_COMPRESSION or FPC_COMPRESSION
+const Compression_Algorithm compression_algorithm = BDI_COMPRESSION;
+const unsigned tags_per_way = 2; // Twice as many tags as an uncompressed set
+const unsigned segment_size = 8; // Compressed blocks are allocated in 8-byte segments
+
+const uint64_t bdi_decompression_latency = 1; // Cycles, a parallel add of the base
+const uint64_t fpc_decompression_latency = 5; // Cycles, a serial prefix decode
+
+Compressed_Cache *initCompressedCache(Cache *cache)
+{
+    Compressed_Cache *cc = (Compressed_Cache *)calloc(1, sizeof(Compressed_Cache));
+    cc->algorithm = compression_algorithm;
+
+    // Same geometry as the regular cache
+    cc->num_sets = cache->num_sets;
+    cc->num_ways = cache->num_ways;
+    cc->blk_size = cache->blk_mask + 1;
+    cc->set_bytes = cc->num_ways * cc->blk_size;
+    cc->max_tags = cc->num_ways * tags_per_way;
+
+    cc->set_shift = cache->set_shift;
+    cc->set_mask = cache->set_mask;
+    cc->tag_shift = cache->tag_shift;
+
+    cc->sets = (Compressed_Set *)calloc(cc->num_sets, sizeof(Compressed_Set));
+    for (unsigned i = 0; i < cc->num_sets; i++)
+    {
+        cc->sets[i].blocks = (Compressed_Block *)malloc(cc->max_tags * sizeof(Compressed_Block));
+    }
+
+    return cc;
+}
+
+uint64_t readValue(const uint8_t *data, unsigned bytes)
+{
+    uint64_t value = 0;
+    for (unsigned i = 0; i < bytes; i++)
+    {
+        value |= (uint64_t)data[i] << (8 * i);
+    }
+    return value;
+}
+
+// Does value, taken as a signed number of from_bytes bytes, fit in to_bytes signed bytes?
+bool fitsSigned(uint64_t value, unsigned from_bytes, unsigned to_bytes)
+{
+    unsigned shift = 64 - 8 * from_bytes;
+    int64_t x = (int64_t)(value << shift) >> shift;
+    int64_t limit = (int64_t)1 << (8 * to_bytes - 1);
+    return x >= -limit && x < limit;
+}
+
+// Base-Delta-Immediate (Pekhimenko et al., PACT 2012): one explicit base plus the implicit zero base
+unsigned bdiSize(const uint8_t *data, unsigned size)
+{
+    bool zeros = true;
+    bool repeated = true;
+    for (unsigned i = 0; i < size; i++)
+    {
+        zeros = zeros && data[i] == 0;
+        repeated = repeated && data[i] == data[i % 8];
+    }
+
+    if (zeros)
+    {
+        return 1;
+    }
+    if (repeated)
+    {
+        return 8;
+    }
+
+    const unsigned base_sizes[] = {8, 4, 2};
+    const unsigned delta_sizes[] = {1, 2, 4};
+    unsigned best = size;
+
+    for (unsigned b = 0; b < 3; b++)
+    {
+        for (unsigned d = 0; d < 3; d++)
+        {
+            unsigned k = base_sizes[b];
+            unsigned delta = delta_sizes[d];
+            if (delta >= k)
+            {
+                continue;
+            }
+
+            uint64_t mask = k == 8 ? UINT64_MAX : ((uint64_t)1 << (8 * k)) - 1;
+            bool have_base = false;
+            uint64_t base = 0;
+            bool fits = true;
+
+            for (unsigned i = 0; i < size && fits; i += k)
+            {
+                uint64_t value = readValue(&data[i], k);
+                if (fitsSigned(value, k, delta))
+                {
+                    continue; // Immediate, relative to zero
+                }
+
+                if (!have_base)
+                {
+                    base = value;
+                    have_base = true;
+                }
+                fits = fitsSigned((value - base) & mask, k, delta);
+            }
+
+            unsigned n = size / k;
+            unsigned encoded = k + n * delta + (n + 7) / 8; // Base, deltas, base-select bits
+            if (fits && encoded < best)
+            {
+                best = encoded;
+            }
+        }
+    }
+
+    return best;
+}
+
+// Frequent Pattern Compression (Alameldeen and Wood, 2004): a 3-bit prefix per 32-bit word
+unsigned fpcSize(const uint8_t *data, unsigned size)
+{
+    unsigned bits = 0;
+
+    for (unsigned i = 0; i < size; )
+    {
+        uint32_t word = (uint32_t)readValue(&data[i], 4);
+
+        if (word == 0)
+        {
+            // Run of up to eight zero words
+            unsigned run = 0;
+            while (i < size && run < 8 && readValue(&data[i], 4) == 0)
+            {
+                i += 4;
+                run++;
+            }
+            bits += 3 + 3;
+            continue;
+        }
+
+        int32_t value = (int32_t)word;
+        uint16_t low = (uint16_t)word;
+        uint16_t high = (uint16_t)(word >> 16);
+        bool repeated_bytes = (word & 0xff) * 0x01010101u == word;
+
+        unsigned payload = 32;
+        if (value >= -8 && value < 8)
+        {
+            payload = 4; // Sign-extended 4 bits
+        }
+        else if ((value >= -128 && value < 128) || repeated_bytes)
+        {
+            payload = 8; // Sign-extended byte, or one byte repeated
+        }
+        else if ((value >= -32768 && value < 32768) || low == 0 ||
+                 (fitsSigned(low, 2, 1) && fitsSigned(high, 2, 1)))
+        {
+            payload = 16; // Sign-extended halfword, zero-padded halfword, or two sign-extended bytes
+        }
+
+        bits += 3 + payload;
+        i += 4;
+    }
+
+    unsigned bytes = (bits + 7) / 8;
+    return bytes < size ? bytes : size;
+}
+
+unsigned compressedSize(Compressed_Cache *cc, Request *req)
+{
+    if (!req->has_data)
+    {
+        return cc->blk_size; // Nothing to compress, store it raw
+    }
+
+    assert(cc->blk_size == REQUEST_DATA_SIZE);
+    unsigned size = cc->algorithm == BDI_COMPRESSION ? bdiSize(req->data, cc->blk_size)
+                                                     : fpcSize(req->data, cc->blk_size);
+
+    size = (size + segment_size - 1) / segment_size * segment_size;
+    return size < cc->blk_size ? size : cc->blk_size;
+}
+
+// Evict from the LRU end until the set fits its tag and byte budgets, never touching the MRU block
+void compressedEvict(Compressed_Cache *cc, Compressed_Set *set)
+{
+    while (set->num_blocks > 1 && (set->bytes_used > cc->set_bytes || set->num_blocks > cc->max_tags))
+    {
+        Compressed_Block *victim = &set->blocks[--set->num_blocks];
+        set->bytes_used -= victim->size;
+        cc->resident_blocks--;
+
+        if (victim->dirty)
+        {
+            cc->write_backs++;
+        }
+    }
+}
+
+bool compressedAccess(Compressed_Cache *cc, Request *req)
+{
+    uint64_t blk_addr = req->load_or_store_addr & ~(uint64_t)(cc->blk_size - 1);
+    Compressed_Set *set = &cc->sets[(blk_addr >> cc->set_shift) & cc->set_mask];
+    uint64_t tag = blk_addr >> cc->tag_shift;
+
+    cc->accesses++;
+
+    unsigned pos = 0;
+    while (pos < set->num_blocks && set->blocks[pos].tag != tag)
+    {
+        pos++;
+    }
+
+    bool hit = pos < set->num_blocks;
+    Compressed_Block blk;
+
+    if (hit)
+    {
+        cc->hits++;
+        if (pos >= cc->num_ways)
+        {
+            cc->extra_hits++; // An uncompressed LRU set would have lost this block already
+        }
+
+        blk = set->blocks[pos];
+        if (blk.size < cc->blk_size)
+        {
+            cc->compressed_hits++;
+            cc->decompression_cycles += cc->algorithm == BDI_COMPRESSION ? bdi_decompression_latency
+                                                                         : fpc_decompression_latency;
+        }
+
+        memmove(&set->blocks[1], &set->blocks[0], pos * sizeof(Compressed_Block));
+        set->bytes_used -= blk.size;
+    }
+    else
+    {
+        if (set->num_blocks == cc->max_tags)
+        {
+            // Out of tags, free the LRU one first
+            Compressed_Block *victim = &set->blocks[--set->num_blocks];
+            set->bytes_used -= victim->size;
+            cc->resident_blocks--;
+            if (victim->dirty)
+            {
+                cc->write_backs++;
+            }
+        }
+
+        memmove(&set->blocks[1], &set->blocks[0], set->num_blocks * sizeof(Compressed_Block));
+        set->num_blocks++;
+        cc->resident_blocks++;
+
+        blk.tag = tag;
+        blk.dirty = false;
+        blk.size = compressedSize(cc, req);
+
+        cc->fills++;
+        cc->fill_bytes += blk.size;
+    }
+
+    // A write with new contents may change the compressed size
+    if (req->req_type != LOAD)
+    {
+        blk.dirty = true;
+        if (hit && req->has_data)
+        {
+            blk.size = compressedSize(cc, req);
+        }
+    }
+
+    set->blocks[0] = blk;
+    set->bytes_used += blk.size;
+    compressedEvict(cc, set);
+
+    cc->resident_sum += cc->resident_blocks;
+    return hit;
+}
+
+const char *compressionName(Compression_Algorithm algorithm)
+{
+    switch (algorithm)
+    {
+        case BDI_COMPRESSION: return "BDI";
+        case FPC_COMPRESSION: return "FPC";
+        default: return "?";
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef __COMPRESSION_H__
+#define __COMPRESSION_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "Cache.h"
+
+// Uncomment to also simulate a compressed cache whose sets hold a byte budget instead of num_ways blocks
+//#define COMPRESSED_CACHE
+
+typedef enum Compression_Algorithm{BDI_COMPRESSION, FPC_COMPRESSION}Compression_Algorithm;
+
+typedef struct Compressed_Block
+{
+    uint64_t tag;
+    unsigned size; // Compressed size in bytes, rounded up to whole segments
+    bool dirty;
+} Compressed_Block;
+
+/* A set is an LRU stack of variable-size blocks, blocks[0] being the MRU one */
+typedef struct Compressed_Set
+{
+    Compressed_Block *blocks;
+    unsigned num_blocks;
+    unsigned bytes_used;
+} Compressed_Set;
+
+typedef struct Compressed_Cache
+{
+    Compression_Algorithm algorithm;
+
+    Compressed_Set *sets;
+    unsigned num_sets;
+    unsigned num_ways; // Blocks an uncompressed set holds
+    unsigned max_tags; // Tags per set
+    unsigned set_bytes; // Data budget per set
+    unsigned blk_size;
+
+    unsigned set_shift;
+    unsigned set_mask;
+    unsigned tag_shift;
+
+    uint64_t accesses;
+    uint64_t hits;
+    uint64_t extra_hits; // Hits beyond the num_ways MRU blocks, i.e. thanks to compression
+    uint64_t resident_blocks;
+    uint64_t resident_sum; // resident_blocks summed over every access, for the effective capacity
+
+    uint64_t fills;
+    uint64_t fill_bytes; // Compressed size summed over every fill
+    uint64_t compressed_hits; // Hits that paid the decompression latency
+    uint64_t decompression_cycles;
+    uint64_t write_backs;
+} Compressed_Cache;
+
+// Function Definitions
+Compressed_Cache *initCompressedCache(Cache *cache);
+bool compressedAccess(Compressed_Cache *cc, Request *req);
+unsigned compressedSize(Compressed_Cache *cc, Request *req);
+unsigned bdiSize(const uint8_t *data, unsigned size);
+unsigned fpcSize(const uint8_t *data, unsigned size);
+const char *compressionName(Compression_Algorithm algorithm);
+
+#endif /* __COMPRESSION_H__ */
@@ -0,0 +1,131 @@
+#include "Dead_Block.h"
+
+/* Constants */
+const unsigned dbp_sampler_sets = 32;
+const unsigned dbp_sampler_ways = 12;
+const unsigned dbp_table_size = 4096;
+const uint8_t dbp_counter_max = 3;
+const unsigned dbp_threshold = 8; // Out of DBP_TABLES * dbp_counter_max
+
+Dead_Block_Predictor *initDeadBlockPredictor(unsigned num_sets)
+{
+    Dead_Block_Predictor *dbp = (Dead_Block_Predictor *)calloc(1, sizeof(Dead_Block_Predictor));
+
+    dbp->num_sampler_sets = num_sets < dbp_sampler_sets ? num_sets : dbp_sampler_sets;
+    dbp->sample_stride = num_sets / dbp->num_sampler_sets;
+    dbp->sampler_ways = dbp_sampler_ways;
+    dbp->sampler = (Sampler_Entry *)calloc(dbp->num_sampler_sets * dbp_sampler_ways, sizeof(Sampler_Entry));
+
+    dbp->table_size = dbp_table_size;
+    for (unsigned t = 0; t < DBP_TABLES; t++)
+    {
+        dbp->tables[t] = (uint8_t *)calloc(dbp_table_size, sizeof(uint8_t));
+    }
+    dbp->threshold = dbp_threshold;
+
+    return dbp;
+}
+
+uint16_t dbpSignature(uint64_t PC)
+{
+    return (uint16_t)((PC ^ (PC >> 15) ^ (PC >> 30)) & 0x7fff);
+}
+
+// Each table hashes the signature differently so that aliasing in one is outvoted by the others
+unsigned dbpIndex(Dead_Block_Predictor *dbp, unsigned table, uint16_t signature)
+{
+    uint32_t h = (uint32_t)signature * (2654435761u + 40503u * table);
+    return (h >> (7 + 3 * table)) % dbp->table_size;
+}
+
+void trainDeadBlock(Dead_Block_Predictor *dbp, uint16_t signature, bool dead)
+{
+    for (unsigned t = 0; t < DBP_TABLES; t++)
+    {
+        uint8_t *counter = &dbp->tables[t][dbpIndex(dbp, t, signature)];
+        if (dead && *counter < dbp_counter_max)
+        {
+            (*counter)++;
+        }
+        else if (!dead && *counter > 0)
+        {
+            (*counter)--;
+        }
+    }
+}
+
+bool predictDead(Dead_Block_Predictor *dbp, uint64_t PC)
+{
+    uint16_t signature = dbpSignature(PC);
+    unsigned sum = 0;
+    for (unsigned t = 0; t < DBP_TABLES; t++)
+    {
+        sum += dbp->tables[t][dbpIndex(dbp, t, signature)];
+    }
+
+    dbp->predictions++;
+    return sum >= dbp->threshold;
+}
+
+// Train on a demand access: a sampler hit means the last PC did not see the block die,
+// a sampler eviction means it did
+void deadBlockAccess(Dead_Block_Predictor *dbp, uint64_t set_idx, uint64_t tag, uint64_t PC)
+{
+    if (set_idx % dbp->sample_stride != 0 || set_idx / dbp->sample_stride >= dbp->num_sampler_sets)
+    {
+        return;
+    }
+
+    Sampler_Entry *set = &dbp->sampler[(set_idx / dbp->sample_stride) * dbp->sampler_ways];
+    uint16_t partial_tag = (uint16_t)(tag ^ (tag >> 16));
+    uint16_t signature = dbpSignature(PC);
+
+    // Step one: look for the block, otherwise take an invalid or the LRU entry
+    Sampler_Entry *entry = NULL;
+    for (unsigned i = 0; i < dbp->sampler_ways; i++)
+    {
+        if (set[i].valid && set[i].partial_tag == partial_tag)
+        {
+            entry = &set[i];
+            trainDeadBlock(dbp, entry->signature, false);
+            break;
+        }
+    }
+
+    if (entry == NULL)
+    {
+        for (unsigned i = 0; i < dbp->sampler_ways; i++)
+        {
+            if (!set[i].valid)
+            {
+                entry = &set[i];
+                entry->lru = dbp->sampler_ways; // Below every valid entry
+                break;
+            }
+
+            if (entry == NULL || set[i].lru > entry->lru)
+            {
+                entry = &set[i];
+            }
+        }
+
+        if (entry->valid)
+        {
+            trainDeadBlock(dbp, entry->signature, true);
+        }
+
+        entry->valid = true;
+        entry->partial_tag = partial_tag;
+    }
+
+    // Step two: move to MRU
+    for (unsigned i = 0; i < dbp->sampler_ways; i++)
+    {
+        if (set[i].valid && &set[i] != entry && set[i].lru < entry->lru)
+        {
+            set[i].lru++;
+        }
+    }
+    entry->lru = 0;
+    entry->signature = signature;
+}
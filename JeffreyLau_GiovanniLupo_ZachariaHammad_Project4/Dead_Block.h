@@ -0,0 +1,46 @@
+#ifndef __DEAD_BLOCK_H__
+#define __DEAD_BLOCK_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Uncomment to let SHP skip allocating blocks predicted dead on arrival
+//#define DEAD_BLOCK_BYPASS
+
+#define DBP_TABLES 3 // Skewed predictor tables, as in SDBP
+
+/* Sampler: a few sets tracked with partial tags and a separate LRU stack */
+typedef struct Sampler_Entry
+{
+    bool valid;
+    uint16_t partial_tag;
+    uint16_t signature; // Hashed PC of the last access
+    uint8_t lru; // 0 is MRU
+} Sampler_Entry;
+
+/* Sampling dead-block predictor (Khan et al., MICRO 2010) */
+typedef struct Dead_Block_Predictor
+{
+    Sampler_Entry *sampler;
+    unsigned num_sampler_sets;
+    unsigned sampler_ways;
+    unsigned sample_stride; // Cache set s is sampled when s % sample_stride == 0
+
+    uint8_t *tables[DBP_TABLES]; // 2-bit counters, high means dead
+    unsigned table_size;
+    unsigned threshold; // Predict dead when the counters sum to at least this
+
+    uint64_t predictions; // Misses that asked whether to allocate
+    uint64_t bypasses;
+    uint64_t bypassed_writes; // Bypassed stores sent straight to memory
+} Dead_Block_Predictor;
+
+// Function Definitions
+Dead_Block_Predictor *initDeadBlockPredictor(unsigned num_sets);
+void deadBlockAccess(Dead_Block_Predictor *dbp, uint64_t set_idx, uint64_t tag, uint64_t PC);
+bool predictDead(Dead_Block_Predictor *dbp, uint64_t PC);
+
+#endif /* __DEAD_BLOCK_H__ */
@@ -1,5 +1,11 @@
 #include "Trace.h"
 #include "Cache.h"
+#include "Opt.h"
+#include "Mshr.h"
+#include "Profiler.h"
+#include "Coherence.h"
+#include "Tlb.h"
+#include "Compression.h"
 
 extern TraceParser *initTraceParser(const char * mem_file);
 extern bool getRequest(TraceParser *mem_trace);
@@ -22,7 +28,23 @@ int main(int argc, const char *argv[])
 
     // Initialize a Cache
     Cache *cache = initCache();
-    
+
+    #if defined(OPT) || defined(OPT_STUDY)
+    // Annotate every request with the time its block is referenced next
+    Next_Use_Oracle *oracle = initNextUseOracle(argv[1], cache->blk_mask);
+    #endif
+
+    #ifdef OPT_STUDY
+    // One cache per policy, all fed the same requests
+    Cache *study_caches[NUM_POLICIES];
+    uint64_t study_hits[NUM_POLICIES] = {0};
+    for (unsigned p = 0; p < NUM_POLICIES; p++)
+    {
+        study_caches[p] = initCache();
+        study_caches[p]->policy = (Replacement_Policy)p;
+    }
+    #endif
+
     // Running the trace
     uint64_t num_of_reqs = 0;
     uint64_t hits = 0;
@@ -30,8 +52,72 @@ int main(int argc, const char *argv[])
     uint64_t num_evicts = 0;
 
     uint64_t cycles = 0;
+
+    #ifdef SET_SAMPLING
+    uint64_t sampled_reqs = 0;
+    #endif
+
+    #ifdef TIMING_MODEL
+    Mshr_File *mshrs = initMshrFile();
+    uint64_t total_latency = 0;
+    uint64_t last_completion = 0;
+    #endif
+
+    #ifdef REUSE_PROFILER
+    Reuse_Profiler *profiler = initReuseProfiler();
+    #endif
+
+    #ifdef COHERENCE
+    Coherence *coherence = initCoherence();
+    #endif
+
+    #ifdef TLB_MODEL
+    Tlb *tlb = initTlb();
+    #endif
+
+    #ifdef COMPRESSED_CACHE
+    Compressed_Cache *compressed = initCompressedCache(cache);
+    #endif
+
     while (getRequest(mem_trace))
     {
+        #if defined(OPT) || defined(OPT_STUDY)
+        mem_trace->cur_req->next_use = getNextUse(oracle);
+        #endif
+
+        #ifdef REUSE_PROFILER
+        profileRequest(profiler, mem_trace->cur_req);
+        #endif
+
+        #ifdef TLB_MODEL
+        // Page-walk loads reach the cache ahead of the access they translate
+        translate(tlb, cache, mem_trace->cur_req, cycles);
+        #endif
+
+        #ifdef SET_SAMPLING
+        // Requests to sets that are not modeled only count towards the total
+        if (!inSampledSet(cache, mem_trace->cur_req->load_or_store_addr))
+        {
+            ++num_of_reqs;
+            ++cycles;
+            continue;
+        }
+        ++sampled_reqs;
+        #endif
+
+        #ifdef TIMING_MODEL
+        // Non-blocking cache: a new miss only stalls issue when every MSHR is busy
+        uint64_t issue_cycle = cycles;
+        uint64_t blk_addr = blkAlign(mem_trace->cur_req->load_or_store_addr, cache->blk_mask);
+        uint64_t completion = timedAccess(mshrs, blk_addr, findBlock(cache, blk_addr) != NULL, &cycles);
+
+        total_latency += completion - issue_cycle;
+        if (completion > last_completion)
+        {
+            last_completion = completion;
+        }
+        #endif
+
         // Step one, accessBlock()
         if (accessBlock(cache, mem_trace->cur_req, cycles))
         {
@@ -40,22 +126,260 @@ int main(int argc, const char *argv[])
         }
         else
         {
-            // Cache miss!
+            // Cache miss! accessBlock() has already inserted the block.
             misses++;
-            // Step two, insertBlock()
-//            printf("Inserting: %"PRIu64"\n", mem_trace->cur_req->load_or_store_addr);
-            uint64_t wb_addr;
-            if (insertBlock(cache, mem_trace->cur_req, cycles, &wb_addr))
+        }
+
+        #ifdef COHERENCE
+        coherentAccess(coherence, mem_trace->cur_req, cycles);
+        #endif
+
+        #ifdef COMPRESSED_CACHE
+        compressedAccess(compressed, mem_trace->cur_req);
+        #endif
+
+        #ifdef OPT_STUDY
+        for (unsigned p = 0; p < NUM_POLICIES; p++)
+        {
+            if (accessBlock(study_caches[p], mem_trace->cur_req, cycles))
             {
-                num_evicts++;
-//                printf("Evicted: %"PRIu64"\n", wb_addr);
+                study_hits[p]++;
             }
         }
+        #endif
 
         ++num_of_reqs;
         ++cycles;
     }
 
+    #if defined(OPT) || defined(OPT_STUDY)
+    freeNextUseOracle(oracle);
+    #endif
+
+    num_evicts = cache->write_back_count;
+
     double hit_rate = (double)hits / ((double)hits + (double)misses);
     printf("Hit rate: %lf%%\n", hit_rate * 100);
+    printf("Write-backs: %"PRIu64"\n", num_evicts);
+
+    #ifdef SET_SAMPLING
+    // Ratio estimator over the modeled sets (cluster sampling), with a 95% confidence interval
+    unsigned sampled_sets = 0;
+    double residuals = 0;
+    for (unsigned i = 0; i < cache->num_sets; i++)
+    {
+        if (cache->set_accesses[i] > 0)
+        {
+            double residual = (double)cache->set_hits[i] - hit_rate * (double)cache->set_accesses[i];
+            residuals += residual * residual;
+            sampled_sets++;
+        }
+    }
+
+    unsigned total_sets = cache->num_sets << cache->sample_shift;
+    double mean_accesses = (double)sampled_reqs / (double)sampled_sets;
+    double variance = sampled_sets > 1 ?
+        (1.0 - (double)cache->num_sets / (double)total_sets) * residuals /
+        ((double)(sampled_sets - 1) * sampled_sets * mean_accesses * mean_accesses) : 0.0;
+    double margin = 1.96 * sqrt(variance);
+
+    printf("Set sampling: %u of %u sets modeled, %"PRIu64" of %"PRIu64" requests simulated\n",
+           cache->num_sets, total_sets, sampled_reqs, num_of_reqs);
+    printf("Estimated hits: %.0lf, misses: %.0lf\n",
+           hit_rate * (double)num_of_reqs, (1.0 - hit_rate) * (double)num_of_reqs);
+    printf("Hit rate 95%% confidence interval: [%lf%%, %lf%%]\n",
+           (hit_rate - margin) * 100, (hit_rate + margin) * 100);
+    #endif
+
+    #ifdef DEAD_BLOCK_BYPASS
+    Dead_Block_Predictor *dbp = cache->dead_block;
+    printf("Bypassed fills: %"PRIu64" (%lf%% of misses), bypassed stores: %"PRIu64"\n",
+           dbp->bypasses, misses ? (double)dbp->bypasses / (double)misses * 100 : 0.0, dbp->bypassed_writes);
+    printf("Memory writes: %"PRIu64" dirty evictions + %"PRIu64" bypassed stores\n",
+           cache->write_back_count - dbp->bypassed_writes, dbp->bypassed_writes);
+    #endif
+
+    #ifdef VICTIM_CACHE
+    Victim_Cache *vc = cache->victim_cache;
+    printf("Victim cache hits: %"PRIu64" (%lf%% of misses), hit rate with victim cache: %lf%%\n",
+           vc->hits, misses ? (double)vc->hits / (double)misses * 100 : 0.0,
+           (double)(hits + vc->hits) / (double)(hits + misses) * 100);
+    #endif
+
+    #ifdef MISS_CLASSIFICATION
+    Miss_Classifier *classifier = cache->classifier;
+    printf("Compulsory misses: %"PRIu64" (%lf%%)\n", classifier->compulsory,
+           misses ? (double)classifier->compulsory / (double)misses * 100 : 0.0);
+    printf("Capacity misses: %"PRIu64" (%lf%%)\n", classifier->capacity,
+           misses ? (double)classifier->capacity / (double)misses * 100 : 0.0);
+    printf("Conflict misses: %"PRIu64" (%lf%%)\n", classifier->conflict,
+           misses ? (double)classifier->conflict / (double)misses * 100 : 0.0);
+    #endif
+
+    #ifdef COHERENCE
+    Coherence_Stats *coherence_stats = &coherence->stats;
+    uint64_t private_accesses = coherence_stats->hits + coherence_stats->misses;
+    printf("Private cache hit rate: %lf%%\n",
+           private_accesses ? (double)coherence_stats->hits / (double)private_accesses * 100 : 0.0);
+    printf("Invalidations: %"PRIu64", upgrades: %"PRIu64", interventions: %"PRIu64", write-backs: %"PRIu64"\n",
+           coherence_stats->invalidations, coherence_stats->upgrades,
+           coherence_stats->interventions, coherence_stats->write_backs);
+    printf("Coherence misses: %"PRIu64" (%lf%% of private misses), true sharing: %"PRIu64", false sharing: %"PRIu64"\n",
+           coherence_stats->coherence_misses,
+           coherence_stats->misses ? (double)coherence_stats->coherence_misses / (double)coherence_stats->misses * 100 : 0.0,
+           coherence_stats->true_sharing, coherence_stats->false_sharing);
+    printf("Directory: %lf KB for a full-map sparse directory, peak %"PRIu64" blocks tracked\n",
+           directoryStorageKB(coherence), coherence->directory->peak_active_entries);
+    #endif
+
+    #ifdef TLB_MODEL
+    printf("TLB (%s pages): L1 hit rate %lf%%, L2 hit rate %lf%%, %"PRIu64" walks\n",
+           pageSizeName(tlb->page_size),
+           (double)tlb->l1_hits / (double)(tlb->l1_hits + tlb->l1_misses) * 100,
+           tlb->l1_misses ? (double)tlb->l2_hits / (double)tlb->l1_misses * 100 : 0.0,
+           tlb->walks);
+    for (unsigned level = PAGE_TABLE_LEVELS; level >= 2; level--)
+    {
+        uint64_t lookups = tlb->pwc_hits[level] + tlb->pwc_misses[level];
+        if (lookups > 0)
+        {
+            printf("Page-walk cache level %u: hit rate %lf%%\n", level,
+                   (double)tlb->pwc_hits[level] / (double)lookups * 100);
+        }
+    }
+    printf("Walk references: %"PRIu64" (%lf%% hit in the cache), translation cycles per request: %lf\n",
+           tlb->walk_refs, tlb->walk_refs ? (double)tlb->walk_ref_hits / (double)tlb->walk_refs * 100 : 0.0,
+           (double)tlb->translation_cycles / (double)num_of_reqs);
+    #endif
+
+    #ifdef COMPRESSED_CACHE
+    // Both LRU, so the gain over the uncompressed cache is exactly the hits beyond num_ways
+    printf("Compressed cache (%s): hit rate %lf%% (%+lf%% over an uncompressed LRU cache), %"PRIu64" hits beyond %u ways\n",
+           compressionName(compressed->algorithm),
+           (double)compressed->hits / (double)compressed->accesses * 100,
+           (double)compressed->extra_hits / (double)compressed->accesses * 100,
+           compressed->extra_hits, compressed->num_ways);
+    printf("Effective capacity: %lfx, average compressed size: %lf bytes, write-backs: %"PRIu64"\n",
+           (double)compressed->resident_sum / (double)compressed->accesses /
+               (double)(compressed->num_sets * compressed->num_ways),
+           compressed->fills ? (double)compressed->fill_bytes / (double)compressed->fills : 0.0,
+           compressed->write_backs);
+    printf("Decompression: %"PRIu64" compressed hits, %"PRIu64" cycles (%lf per hit)\n",
+           compressed->compressed_hits, compressed->decompression_cycles,
+           compressed->hits ? (double)compressed->decompression_cycles / (double)compressed->hits : 0.0);
+    #endif
+
+    #ifdef PC_STATS
+    printTopStats(cache->pc_stats, "PC", 10);
+    printTopStats(cache->core_access_stats, "core", 10);
+    writeStatsCsv(cache->pc_stats, "PC", "pc_stats.csv");
+    writeStatsCsv(cache->core_access_stats, "core", "core_stats.csv");
+    #endif
+
+    #ifdef WRITE_BACK_BUFFER
+    // The trace has no instruction count, so traffic is normalized per thousand requests
+    Wb_Buffer *wb_buffer = cache->wb_buffer;
+    uint64_t write_bytes = (wb_buffer->inserted - wb_buffer->coalesced) * (cache->blk_mask + 1);
+    printf("Write-back buffer: %"PRIu64" write-backs (%"PRIu64" coalesced, %"PRIu64" eager), %"PRIu64" full stalls, "
+           "%"PRIu64" misses served from the buffer, average occupancy %lf\n",
+           wb_buffer->inserted, wb_buffer->coalesced, wb_buffer->eager, wb_buffer->full_stalls,
+           wb_buffer->read_hits, (double)wb_buffer->occupancy_sum / (double)(hits + misses));
+    printf("Write traffic: %"PRIu64" bytes, %lf bytes per kilo-request\n",
+           write_bytes, (double)write_bytes / (double)num_of_reqs * 1000);
+    #endif
+
+    #ifdef WAY_PREDICTION
+    Way_Predictor *wp = cache->way_predictor;
+    printf("Way prediction (%s): first-probe hit rate %lf%% of hits\n", wayPredictorName(wp->type),
+           wp->hits ? (double)wp->first_probe_hits / (double)wp->hits * 100 : 0.0);
+    for (unsigned s = 0; s < NUM_LOOKUP_SCHEMES; s++)
+    {
+        printf("%s lookup: %lf pJ, %lf cycles per access\n", lookupSchemeName((Lookup_Scheme)s),
+               wp->energy[s] / (double)wp->lookups, (double)wp->latency[s] / (double)wp->lookups);
+    }
+    #endif
+
+    #ifdef TIMING_MODEL
+    uint64_t total_cycles = last_completion > cycles ? last_completion : cycles;
+    printf("Total cycles: %"PRIu64"\n", total_cycles);
+    printf("MLP: %lf\n", mshrs->busy_cycles ? (double)mshrs->miss_cycles / (double)mshrs->busy_cycles : 0.0);
+    printf("AMAT: %lf cycles\n", (double)total_latency / (double)(hits + misses));
+    printf("Primary misses: %"PRIu64", secondary misses: %"PRIu64", MSHR stalls: %"PRIu64" (%"PRIu64" cycles)\n",
+           mshrs->primary_misses, mshrs->secondary_misses, mshrs->stalls, mshrs->stall_cycles);
+    #endif
+
+    #ifdef OPT_STUDY
+    double opt_hit_rate = (double)study_hits[OPT_POLICY] / (double)(hits + misses);
+    for (unsigned p = 0; p < NUM_POLICIES; p++)
+    {
+        double policy_hit_rate = (double)study_hits[p] / (double)(hits + misses);
+        printf("%s: hit rate %lf%%, gap to OPT %lf%% (%.1lf%% of OPT hits)\n",
+               policyName((Replacement_Policy)p), policy_hit_rate * 100,
+               (opt_hit_rate - policy_hit_rate) * 100,
+               study_hits[OPT_POLICY] ? (double)study_hits[p] / (double)study_hits[OPT_POLICY] * 100 : 0.0);
+    }
+    #endif
+
+    #ifdef PREFETCHING
+    for (unsigned p = 0; p < cache->num_prefetchers; p++)
+    {
+        Prefetcher_Stats *stats = &cache->prefetchers[p].stats;
+        uint64_t total_useful = 0;
+        for (unsigned i = 0; i < cache->num_prefetchers; i++)
+        {
+            total_useful += cache->prefetchers[i].stats.useful;
+        }
+
+        // Coverage: share of the misses a cache without prefetching would have taken
+        double coverage = (double)stats->useful / (double)(cache->demand_misses + total_useful);
+        double accuracy = stats->issued ? (double)stats->useful / (double)stats->issued : 0.0;
+        double timeliness = stats->useful ? (double)(stats->useful - stats->late) / (double)stats->useful : 0.0;
+
+        printf("%s prefetcher: issued %"PRIu64", useful %"PRIu64", coverage %lf%%, accuracy %lf%%, "
+               "timeliness %lf%% (%"PRIu64" late), useless %"PRIu64", pollution misses %"PRIu64"\n",
+               prefetcherName(cache->prefetchers[p].type), stats->issued, stats->useful,
+               coverage * 100, accuracy * 100, timeliness * 100, stats->late,
+               stats->useless, stats->pollution);
+    }
+    #endif
+
+    #ifdef SHARED_LLC
+    // Per-core view of the shared cache
+    double min_hit_rate = 1.0;
+    double max_hit_rate = 0.0;
+    for (unsigned i = 0; i < cache->num_cores; i++)
+    {
+        Core_Stats *stats = &cache->core_stats[i];
+        uint64_t accesses = stats->hits + stats->misses;
+        double core_hit_rate = accesses ? (double)stats->hits / (double)accesses : 0.0;
+        double avg_occupancy = hits + misses ? (double)stats->occupancy_sum / (double)(hits + misses) : 0.0;
+
+        printf("Core %u: accesses %"PRIu64", hit rate %lf%%, avg occupancy %.1lf blocks (%.1lf%%), "
+               "evictions %"PRIu64" (%"PRIu64" by other cores)",
+               i, accesses, core_hit_rate * 100, avg_occupancy,
+               avg_occupancy / cache->num_blocks * 100,
+               stats->evictions, stats->evicted_by_others);
+        if (cache->partition != NULL)
+        {
+            printf(", ways %u", cache->partition->quota[i]);
+        }
+        printf("\n");
+
+        if (accesses)
+        {
+            min_hit_rate = core_hit_rate < min_hit_rate ? core_hit_rate : min_hit_rate;
+            max_hit_rate = core_hit_rate > max_hit_rate ? core_hit_rate : max_hit_rate;
+        }
+    }
+    printf("Fairness (min/max core hit rate): %lf\n",
+           max_hit_rate > 0 ? min_hit_rate / max_hit_rate : 0.0);
+    if (cache->partition != NULL && cache->partition->umon != NULL)
+    {
+        printf("Repartitions: %"PRIu64"\n", cache->partition->num_repartitions);
+    }
+    #endif
+
+    #ifdef REUSE_PROFILER
+    dumpReuseProfile(profiler);
+    #endif
 }
@@ -0,0 +1,134 @@
+#include "Mshr.h"
+
+/* Constants */
+const unsigned num_mshrs = 16;
+const uint64_t hit_latency = 20; // Cycles (LLC hit)
+const uint64_t miss_latency = 200; // Cycles (memory)
+
+Mshr_File *initMshrFile()
+{
+    Mshr_File *mshrs = (Mshr_File *)malloc(sizeof(Mshr_File));
+    mshrs->num_entries = num_mshrs;
+    mshrs->entries = (Mshr_Entry *)calloc(num_mshrs, sizeof(Mshr_Entry));
+    mshrs->num_busy = 0;
+
+    mshrs->hit_latency = hit_latency;
+    mshrs->miss_latency = miss_latency;
+
+    mshrs->primary_misses = 0;
+    mshrs->secondary_misses = 0;
+    mshrs->stalls = 0;
+    mshrs->stall_cycles = 0;
+
+    mshrs->miss_cycles = 0;
+    mshrs->busy_cycles = 0;
+    mshrs->busy_until = 0;
+
+    return mshrs;
+}
+
+// Free every MSHR whose fill has returned by cycle
+void retireMshrs(Mshr_File *mshrs, uint64_t cycle)
+{
+    for (unsigned i = 0; i < mshrs->num_entries; i++)
+    {
+        if (mshrs->entries[i].valid && mshrs->entries[i].ready <= cycle)
+        {
+            mshrs->entries[i].valid = false;
+            mshrs->num_busy--;
+        }
+    }
+}
+
+Mshr_Entry *findMshr(Mshr_File *mshrs, uint64_t blk_addr)
+{
+    for (unsigned i = 0; i < mshrs->num_entries; i++)
+    {
+        if (mshrs->entries[i].valid && mshrs->entries[i].blk_addr == blk_addr)
+        {
+            return &mshrs->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+uint64_t earliestMshr(Mshr_File *mshrs)
+{
+    uint64_t earliest = UINT64_MAX;
+    for (unsigned i = 0; i < mshrs->num_entries; i++)
+    {
+        if (mshrs->entries[i].valid && mshrs->entries[i].ready < earliest)
+        {
+            earliest = mshrs->entries[i].ready;
+        }
+    }
+
+    return earliest;
+}
+
+Mshr_Entry *allocateMshr(Mshr_File *mshrs, uint64_t blk_addr, uint64_t cycle)
+{
+    assert(mshrs->num_busy < mshrs->num_entries);
+
+    for (unsigned i = 0; i < mshrs->num_entries; i++)
+    {
+        Mshr_Entry *entry = &mshrs->entries[i];
+        if (!entry->valid)
+        {
+            entry->valid = true;
+            entry->blk_addr = blk_addr;
+            entry->ready = cycle + mshrs->miss_latency;
+            mshrs->num_busy++;
+
+            // Track the union of miss intervals for MLP
+            uint64_t start = cycle > mshrs->busy_until ? cycle : mshrs->busy_until;
+            if (entry->ready > start)
+            {
+                mshrs->busy_cycles += entry->ready - start;
+                mshrs->busy_until = entry->ready;
+            }
+            mshrs->miss_cycles += mshrs->miss_latency;
+
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Time one request issued at *cycle; hit tells whether the block is (functionally)
+ * present. Stalls by advancing *cycle when a new miss finds no free MSHR.
+ * Returns the cycle the request completes.
+ */
+uint64_t timedAccess(Mshr_File *mshrs, uint64_t blk_addr, bool hit, uint64_t *cycle)
+{
+    retireMshrs(mshrs, *cycle);
+
+    // A block still in flight is a secondary miss, whatever the tags say
+    Mshr_Entry *pending = findMshr(mshrs, blk_addr);
+    if (pending != NULL)
+    {
+        mshrs->secondary_misses++;
+        return pending->ready;
+    }
+
+    if (hit)
+    {
+        return *cycle + mshrs->hit_latency;
+    }
+
+    if (mshrs->num_busy == mshrs->num_entries)
+    {
+        // Every MSHR is busy: wait for the first fill to return
+        uint64_t earliest = earliestMshr(mshrs);
+        mshrs->stalls++;
+        mshrs->stall_cycles += earliest - *cycle;
+        *cycle = earliest;
+        retireMshrs(mshrs, *cycle);
+    }
+
+    mshrs->primary_misses++;
+    return allocateMshr(mshrs, blk_addr, *cycle)->ready;
+}
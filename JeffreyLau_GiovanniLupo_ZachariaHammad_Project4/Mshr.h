@@ -0,0 +1,46 @@
+#ifndef __MSHR_H__
+#define __MSHR_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* One outstanding miss */
+typedef struct Mshr_Entry
+{
+    bool valid;
+    uint64_t blk_addr;
+    uint64_t ready; // Cycle the fill returns
+} Mshr_Entry;
+
+/* Miss status holding registers of a non-blocking cache */
+typedef struct Mshr_File
+{
+    Mshr_Entry *entries;
+    unsigned num_entries;
+    unsigned num_busy;
+
+    uint64_t hit_latency;
+    uint64_t miss_latency;
+
+    uint64_t primary_misses;
+    uint64_t secondary_misses; // Merged into an outstanding miss to the same block
+    uint64_t stalls; // Requests that found every MSHR busy
+    uint64_t stall_cycles;
+
+    uint64_t miss_cycles; // Sum of the service time of every primary miss
+    uint64_t busy_cycles; // Cycles with at least one miss outstanding
+    uint64_t busy_until;
+} Mshr_File;
+
+// Function Definitions
+Mshr_File *initMshrFile();
+void retireMshrs(Mshr_File *mshrs, uint64_t cycle);
+Mshr_Entry *findMshr(Mshr_File *mshrs, uint64_t blk_addr);
+uint64_t earliestMshr(Mshr_File *mshrs);
+Mshr_Entry *allocateMshr(Mshr_File *mshrs, uint64_t blk_addr, uint64_t cycle);
+uint64_t timedAccess(Mshr_File *mshrs, uint64_t blk_addr, bool hit, uint64_t *cycle);
+
+#endif /* __MSHR_H__ */
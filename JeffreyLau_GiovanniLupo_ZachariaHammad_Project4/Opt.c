@@ -0,0 +1,180 @@
+#include "Opt.h"
+
+/* Constants */
+const uint64_t opt_chunk_size = 1 << 20; // Requests annotated per chunk
+
+static uint64_t hashBlock(uint64_t blk_addr)
+{
+    blk_addr ^= blk_addr >> 33;
+    blk_addr *= 0xff51afd7ed558ccdULL;
+    blk_addr ^= blk_addr >> 33;
+    return blk_addr;
+}
+
+static void initNextUseMap(Next_Use_Map *map, uint64_t capacity)
+{
+    map->capacity = capacity;
+    map->size = 0;
+    map->keys = (uint64_t *)malloc(capacity * sizeof(uint64_t));
+    map->values = (uint64_t *)malloc(capacity * sizeof(uint64_t));
+
+    for (uint64_t i = 0; i < capacity; i++)
+    {
+        map->keys[i] = UINT64_MAX;
+    }
+}
+
+// Returns the slot holding blk_addr, or the empty slot it would go into.
+static uint64_t findSlot(Next_Use_Map *map, uint64_t blk_addr)
+{
+    uint64_t mask = map->capacity - 1;
+    uint64_t slot = hashBlock(blk_addr) & mask;
+
+    while (map->keys[slot] != UINT64_MAX && map->keys[slot] != blk_addr)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+// Record that blk_addr is referenced at index, returning its previous (later) reference.
+static uint64_t swapNextUse(Next_Use_Map *map, uint64_t blk_addr, uint64_t index)
+{
+    if (2 * (map->size + 1) > map->capacity)
+    {
+        // Grow to keep the load factor under one half
+        Next_Use_Map bigger;
+        initNextUseMap(&bigger, map->capacity * 2);
+        for (uint64_t i = 0; i < map->capacity; i++)
+        {
+            if (map->keys[i] != UINT64_MAX)
+            {
+                uint64_t slot = findSlot(&bigger, map->keys[i]);
+                bigger.keys[slot] = map->keys[i];
+                bigger.values[slot] = map->values[i];
+            }
+        }
+        bigger.size = map->size;
+
+        free(map->keys);
+        free(map->values);
+        *map = bigger;
+    }
+
+    uint64_t slot = findSlot(map, blk_addr);
+    uint64_t next_use = NO_NEXT_USE;
+
+    if (map->keys[slot] == blk_addr)
+    {
+        next_use = map->values[slot];
+    }
+    else
+    {
+        map->keys[slot] = blk_addr;
+        map->size++;
+    }
+    map->values[slot] = index;
+
+    return next_use;
+}
+
+Next_Use_Oracle *initNextUseOracle(const char *mem_file, uint64_t blk_mask)
+{
+    // Step one: forward pass to find where every chunk starts in the trace
+    uint64_t num_chunks = 0;
+    uint64_t max_chunks = 16;
+    long *chunk_offsets = (long *)malloc(max_chunks * sizeof(long));
+
+    TraceParser *mem_trace = initTraceParser(mem_file);
+    assert(mem_trace->fd != NULL);
+
+    uint64_t num_reqs = 0;
+    long offset = ftell(mem_trace->fd);
+    while (getRequest(mem_trace))
+    {
+        if (num_reqs % opt_chunk_size == 0)
+        {
+            if (num_chunks == max_chunks)
+            {
+                max_chunks *= 2;
+                chunk_offsets = (long *)realloc(chunk_offsets, max_chunks * sizeof(long));
+            }
+            chunk_offsets[num_chunks++] = offset;
+        }
+        ++num_reqs;
+        offset = ftell(mem_trace->fd);
+    }
+
+    // Step two: walk the chunks backwards, annotating each one in reverse
+    Next_Use_Oracle *oracle = (Next_Use_Oracle *)malloc(sizeof(Next_Use_Oracle));
+    oracle->fd = tmpfile();
+    assert(oracle->fd != NULL);
+    oracle->num_reqs = num_reqs;
+    oracle->cur_req = 0;
+    oracle->buffer = (uint64_t *)malloc(opt_chunk_size * sizeof(uint64_t));
+    oracle->buffered = 0;
+    oracle->buf_pos = 0;
+
+    uint64_t *blk_addrs = (uint64_t *)malloc(opt_chunk_size * sizeof(uint64_t));
+
+    Next_Use_Map map;
+    initNextUseMap(&map, 1024);
+
+    for (uint64_t chunk = num_chunks; chunk-- > 0;)
+    {
+        uint64_t first = chunk * opt_chunk_size;
+        uint64_t count = num_reqs - first < opt_chunk_size ? num_reqs - first : opt_chunk_size;
+
+        mem_trace = initTraceParser(mem_file);
+        fseek(mem_trace->fd, chunk_offsets[chunk], SEEK_SET);
+        for (uint64_t i = 0; i < count; i++)
+        {
+            bool more = getRequest(mem_trace);
+            assert(more);
+            blk_addrs[i] = mem_trace->cur_req->load_or_store_addr & ~blk_mask;
+        }
+        fclose(mem_trace->fd);
+        free(mem_trace->cur_req);
+        free(mem_trace);
+
+        for (uint64_t i = count; i-- > 0;)
+        {
+            oracle->buffer[i] = swapNextUse(&map, blk_addrs[i], first + i);
+        }
+
+        fseek(oracle->fd, (long)(first * sizeof(uint64_t)), SEEK_SET);
+        fwrite(oracle->buffer, sizeof(uint64_t), count, oracle->fd);
+    }
+
+    free(blk_addrs);
+    free(map.keys);
+    free(map.values);
+    free(chunk_offsets);
+
+    rewind(oracle->fd);
+    return oracle;
+}
+
+// Next-use index of the next request in trace order
+uint64_t getNextUse(Next_Use_Oracle *oracle)
+{
+    assert(oracle->cur_req < oracle->num_reqs);
+
+    if (oracle->buf_pos == oracle->buffered)
+    {
+        oracle->buffered = fread(oracle->buffer, sizeof(uint64_t), opt_chunk_size, oracle->fd);
+        oracle->buf_pos = 0;
+        assert(oracle->buffered > 0);
+    }
+
+    ++oracle->cur_req;
+    return oracle->buffer[oracle->buf_pos++];
+}
+
+void freeNextUseOracle(Next_Use_Oracle *oracle)
+{
+    fclose(oracle->fd);
+    free(oracle->buffer);
+    free(oracle);
+}
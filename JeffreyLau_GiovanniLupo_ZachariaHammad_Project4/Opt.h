@@ -0,0 +1,45 @@
+#ifndef __OPT_H__
+#define __OPT_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Trace.h"
+
+#define NO_NEXT_USE UINT64_MAX // The block is never referenced again
+
+/* Block address -> request index map used by the reverse pass */
+typedef struct Next_Use_Map
+{
+    uint64_t *keys;
+    uint64_t *values;
+    uint64_t capacity; // Always a power of two
+    uint64_t size;
+} Next_Use_Map;
+
+/*
+ * Offline oracle that knows, for every request, when its block is
+ * referenced next. The trace is annotated in one reverse pass, one chunk at
+ * a time, so memory is bounded by the chunk size plus the block footprint.
+ */
+typedef struct Next_Use_Oracle
+{
+    FILE *fd; // Temporary file holding one uint64_t next-use index per request
+
+    uint64_t num_reqs;
+    uint64_t cur_req; // Index of the next request to be annotated
+
+    uint64_t *buffer; // Sequential read buffer over fd
+    uint64_t buffered;
+    uint64_t buf_pos;
+} Next_Use_Oracle;
+
+// Function Definitions
+Next_Use_Oracle *initNextUseOracle(const char *mem_file, uint64_t blk_mask);
+uint64_t getNextUse(Next_Use_Oracle *oracle);
+void freeNextUseOracle(Next_Use_Oracle *oracle);
+
+#endif /* __OPT_H__ */
@@ -0,0 +1,164 @@
+#include "Partition.h"
+
+/* Constants */
+const unsigned umon_sample_shift = 3; // Monitor one out of every 8 sets
+const uint64_t ucp_interval = 4096; // Repartition every 4096 accesses
+
+Partition *initStaticPartition(unsigned num_cores, unsigned num_ways)
+{
+    assert(num_cores <= num_ways); // Every core needs at least one way
+
+    Partition *partition = (Partition *)malloc(sizeof(Partition));
+    partition->num_cores = num_cores;
+    partition->num_ways = num_ways;
+    partition->umon = NULL;
+    partition->accesses = 0;
+    partition->interval = 0;
+    partition->num_repartitions = 0;
+
+    // Split the ways evenly, the first cores get the remainder
+    partition->quota = (unsigned *)malloc(num_cores * sizeof(unsigned));
+    for (unsigned i = 0; i < num_cores; i++)
+    {
+        partition->quota[i] = num_ways / num_cores + (i < num_ways % num_cores ? 1 : 0);
+    }
+
+    return partition;
+}
+
+Partition *initUCPPartition(unsigned num_cores, unsigned num_ways, unsigned num_sets)
+{
+    // Start from an even split until the monitors have something to say
+    Partition *partition = initStaticPartition(num_cores, num_ways);
+    partition->interval = ucp_interval;
+
+    UMON *umon = (UMON *)malloc(sizeof(UMON));
+    umon->sample_shift = umon_sample_shift;
+    umon->num_sampled_sets = num_sets >> umon_sample_shift;
+    if (umon->num_sampled_sets == 0)
+    {
+        umon->sample_shift = 0;
+        umon->num_sampled_sets = num_sets;
+    }
+    umon->num_ways = num_ways;
+
+    unsigned num_tags = num_cores * umon->num_sampled_sets * num_ways;
+    umon->atd = (uint64_t *)malloc(num_tags * sizeof(uint64_t));
+    for (unsigned i = 0; i < num_tags; i++)
+    {
+        umon->atd[i] = UINT64_MAX;
+    }
+
+    umon->way_hits = (uint64_t *)calloc(num_cores * num_ways, sizeof(uint64_t));
+
+    partition->umon = umon;
+    return partition;
+}
+
+// Look up the core's auxiliary tag directory, as if it owned the whole cache.
+void umonAccess(Partition *partition, int core_id, uint64_t set_idx, uint64_t tag)
+{
+    UMON *umon = partition->umon;
+    if (umon == NULL)
+    {
+        return;
+    }
+
+    if (++partition->accesses >= partition->interval)
+    {
+        repartition(partition);
+    }
+
+    if (set_idx & ((1 << umon->sample_shift) - 1))
+    {
+        return; // Not a monitored set
+    }
+
+    uint64_t sampled_set = set_idx >> umon->sample_shift;
+    uint64_t *stack = &umon->atd[((uint64_t)core_id * umon->num_sampled_sets + sampled_set) * umon->num_ways];
+
+    // Find the stack position of the tag, or fall off the LRU end
+    unsigned pos = umon->num_ways - 1;
+    for (unsigned i = 0; i < umon->num_ways; i++)
+    {
+        if (stack[i] == tag)
+        {
+            umon->way_hits[core_id * umon->num_ways + i]++;
+            pos = i;
+            break;
+        }
+    }
+
+    // Move to MRU
+    for (unsigned i = pos; i > 0; i--)
+    {
+        stack[i] = stack[i - 1];
+    }
+    stack[0] = tag;
+}
+
+// UCP lookahead allocation (Qureshi and Patt, MICRO 2006)
+void repartition(Partition *partition)
+{
+    UMON *umon = partition->umon;
+    unsigned num_cores = partition->num_cores;
+    unsigned num_ways = partition->num_ways;
+
+    // Every core keeps at least one way
+    unsigned balance = num_ways - num_cores;
+    for (unsigned c = 0; c < num_cores; c++)
+    {
+        partition->quota[c] = 1;
+    }
+
+    while (balance > 0)
+    {
+        unsigned best_core = 0;
+        unsigned best_ways = 1;
+        double best_mu = -1.0;
+
+        for (unsigned c = 0; c < num_cores; c++)
+        {
+            uint64_t *hits = &umon->way_hits[c * num_ways];
+            unsigned alloc = partition->quota[c];
+
+            // Maximum marginal utility over every possible extra allocation
+            uint64_t gain = 0;
+            for (unsigned k = 1; k <= balance && alloc + k <= num_ways; k++)
+            {
+                gain += hits[alloc + k - 1];
+                double mu = (double)gain / k;
+                if (mu > best_mu)
+                {
+                    best_mu = mu;
+                    best_core = c;
+                    best_ways = k;
+                }
+            }
+        }
+
+        partition->quota[best_core] += best_ways;
+        balance -= best_ways;
+    }
+
+    // Age the monitors so the partition follows phase changes
+    for (unsigned i = 0; i < num_cores * num_ways; i++)
+    {
+        umon->way_hits[i] >>= 1;
+    }
+
+    partition->accesses = 0;
+    partition->num_repartitions++;
+}
+
+void freePartition(Partition *partition)
+{
+    if (partition->umon != NULL)
+    {
+        free(partition->umon->atd);
+        free(partition->umon->way_hits);
+        free(partition->umon);
+    }
+    free(partition->quota);
+    free(partition);
+}
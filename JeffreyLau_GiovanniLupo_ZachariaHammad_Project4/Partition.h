@@ -0,0 +1,55 @@
+#ifndef __PARTITION_H__
+#define __PARTITION_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Per-core statistics of a shared cache */
+typedef struct Core_Stats
+{
+    uint64_t hits;
+    uint64_t misses;
+
+    uint64_t occupancy; // Number of valid blocks currently owned by this core
+    uint64_t occupancy_sum; // Sum of occupancy sampled on every access (for the average)
+
+    uint64_t evictions; // Blocks of this core evicted (by anyone)
+    uint64_t evicted_by_others; // Blocks of this core evicted by another core's fill
+} Core_Stats;
+
+/* Utility Monitor (UMON) - an auxiliary tag directory per core */
+typedef struct UMON
+{
+    unsigned num_sampled_sets;
+    unsigned sample_shift; // One out of (1 << sample_shift) sets is monitored
+    unsigned num_ways;
+
+    uint64_t *atd; // [core][sampled set][way] tags, way 0 is the MRU position
+    uint64_t *way_hits; // [core][way] hits at each LRU stack position
+} UMON;
+
+/* Way-partitioning state of a shared cache */
+typedef struct Partition
+{
+    unsigned num_cores;
+    unsigned num_ways;
+
+    unsigned *quota; // Number of ways allotted to each core
+
+    UMON *umon; // NULL for static partitioning
+    uint64_t accesses; // Accesses since the last repartition
+    uint64_t interval; // Repartition every interval accesses
+    uint64_t num_repartitions;
+} Partition;
+
+// Function Definitions
+Partition *initStaticPartition(unsigned num_cores, unsigned num_ways);
+Partition *initUCPPartition(unsigned num_cores, unsigned num_ways, unsigned num_sets);
+void umonAccess(Partition *partition, int core_id, uint64_t set_idx, uint64_t tag);
+void repartition(Partition *partition);
+void freePartition(Partition *partition);
+
+#endif /* __PARTITION_H__ */
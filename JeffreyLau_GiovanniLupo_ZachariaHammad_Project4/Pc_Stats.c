@@ -0,0 +1,151 @@
+#include "Pc_Stats.h"
+
+/* Constants */
+const uint64_t stats_map_initial_capacity = 256;
+
+Stats_Map *initStatsMap()
+{
+    Stats_Map *map = (Stats_Map *)malloc(sizeof(Stats_Map));
+    map->capacity = stats_map_initial_capacity;
+    map->size = 0;
+    map->entries = (Access_Stats *)malloc(map->capacity * sizeof(Access_Stats));
+    for (uint64_t i = 0; i < map->capacity; i++)
+    {
+        map->entries[i].key = UINT64_MAX;
+    }
+    return map;
+}
+
+Access_Stats *findStatsSlot(Stats_Map *map, uint64_t key)
+{
+    uint64_t mask = map->capacity - 1;
+    uint64_t slot = (key * 0x9e3779b97f4a7c15ULL) >> 20 & mask;
+
+    while (map->entries[slot].key != UINT64_MAX && map->entries[slot].key != key)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return &map->entries[slot];
+}
+
+void growStatsMap(Stats_Map *map)
+{
+    Access_Stats *old_entries = map->entries;
+    uint64_t old_capacity = map->capacity;
+
+    map->capacity *= 2;
+    map->entries = (Access_Stats *)malloc(map->capacity * sizeof(Access_Stats));
+    for (uint64_t i = 0; i < map->capacity; i++)
+    {
+        map->entries[i].key = UINT64_MAX;
+    }
+
+    for (uint64_t i = 0; i < old_capacity; i++)
+    {
+        if (old_entries[i].key != UINT64_MAX)
+        {
+            *findStatsSlot(map, old_entries[i].key) = old_entries[i];
+        }
+    }
+
+    free(old_entries);
+}
+
+// Counters of key, zeroed on first use. The pointer is only valid until the next call.
+Access_Stats *statsEntry(Stats_Map *map, uint64_t key)
+{
+    assert(key != UINT64_MAX);
+
+    Access_Stats *entry = findStatsSlot(map, key);
+    if (entry->key == key)
+    {
+        return entry;
+    }
+
+    if (2 * (map->size + 1) > map->capacity)
+    {
+        growStatsMap(map);
+        entry = findStatsSlot(map, key);
+    }
+
+    entry->key = key;
+    entry->accesses = 0;
+    entry->misses = 0;
+    entry->write_backs = 0;
+    entry->evictions = 0;
+    map->size++;
+
+    return entry;
+}
+
+int compareMisses(const void *a, const void *b)
+{
+    const Access_Stats *x = (const Access_Stats *)a;
+    const Access_Stats *y = (const Access_Stats *)b;
+
+    if (x->misses != y->misses)
+    {
+        return x->misses < y->misses ? 1 : -1;
+    }
+    return x->key < y->key ? -1 : (x->key > y->key);
+}
+
+// Entries sorted by misses, most first; the caller frees the array
+Access_Stats *sortedStats(Stats_Map *map)
+{
+    Access_Stats *sorted = (Access_Stats *)malloc((map->size ? map->size : 1) * sizeof(Access_Stats));
+    uint64_t n = 0;
+    for (uint64_t i = 0; i < map->capacity; i++)
+    {
+        if (map->entries[i].key != UINT64_MAX)
+        {
+            sorted[n++] = map->entries[i];
+        }
+    }
+
+    qsort(sorted, n, sizeof(Access_Stats), compareMisses);
+    return sorted;
+}
+
+void printTopStats(Stats_Map *map, const char *key_name, unsigned top_n)
+{
+    Access_Stats *sorted = sortedStats(map);
+
+    uint64_t total_misses = 0;
+    for (uint64_t i = 0; i < map->size; i++)
+    {
+        total_misses += sorted[i].misses;
+    }
+
+    printf("Top %s by misses (%"PRIu64" %ss):\n", key_name, map->size, key_name);
+    for (uint64_t i = 0; i < map->size && i < top_n; i++)
+    {
+        Access_Stats *s = &sorted[i];
+        printf("  %s %"PRIu64": %"PRIu64" accesses, %"PRIu64" misses (%.2lf%% of all, miss rate %.2lf%%), "
+               "%"PRIu64" write-backs, %"PRIu64" evictions\n",
+               key_name, s->key, s->accesses, s->misses,
+               total_misses ? (double)s->misses / (double)total_misses * 100 : 0.0,
+               s->accesses ? (double)s->misses / (double)s->accesses * 100 : 0.0,
+               s->write_backs, s->evictions);
+    }
+
+    free(sorted);
+}
+
+void writeStatsCsv(Stats_Map *map, const char *key_name, const char *file_name)
+{
+    FILE *fd = fopen(file_name, "w");
+    assert(fd != NULL);
+
+    Access_Stats *sorted = sortedStats(map);
+    fprintf(fd, "%s,accesses,misses,write_backs,evictions\n", key_name);
+    for (uint64_t i = 0; i < map->size; i++)
+    {
+        fprintf(fd, "%"PRIu64",%"PRIu64",%"PRIu64",%"PRIu64",%"PRIu64"\n", sorted[i].key,
+                sorted[i].accesses, sorted[i].misses, sorted[i].write_backs, sorted[i].evictions);
+    }
+
+    free(sorted);
+    fclose(fd);
+}
@@ -0,0 +1,39 @@
+#ifndef __PC_STATS_H__
+#define __PC_STATS_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+// Uncomment to attribute accesses, misses, write-backs and evictions to every PC and core
+//#define PC_STATS
+
+typedef struct Access_Stats
+{
+    uint64_t key; // PC or core id, UINT64_MAX marks an empty slot
+    uint64_t accesses;
+    uint64_t misses;
+    uint64_t write_backs; // Dirty blocks written back to make room for this key's fills
+    uint64_t evictions; // Valid blocks evicted by this key's fills
+} Access_Stats;
+
+/* Open-addressing map, linear probing, kept at most half full */
+typedef struct Stats_Map
+{
+    Access_Stats *entries;
+    uint64_t capacity;
+    uint64_t size;
+} Stats_Map;
+
+// Function Definitions
+Stats_Map *initStatsMap();
+Access_Stats *statsEntry(Stats_Map *map, uint64_t key);
+void printTopStats(Stats_Map *map, const char *key_name, unsigned top_n);
+void writeStatsCsv(Stats_Map *map, const char *key_name, const char *file_name);
+
+#endif /* __PC_STATS_H__ */
@@ -0,0 +1,371 @@
+#include "Prefetcher.h"
+
+/* Constants */
+const unsigned next_line_degree = 1;
+
+const unsigned stride_table_size = 256;
+const unsigned stride_degree = 2;
+const uint8_t stride_max_confidence = 3;
+const uint8_t stride_threshold = 2; // Prefetch once the stride has been confirmed twice
+
+const unsigned stream_table_size = 16;
+const unsigned stream_degree = 4;
+const unsigned stream_region_shift = 6; // 64 blocks (4KB) per region
+const int64_t stream_window = 16; // Blocks a stream may jump and still be the same stream
+
+const unsigned bo_max_offset = 64;
+const unsigned bo_rr_size = 256;
+const unsigned bo_score_max = 31;
+const unsigned bo_round_max = 100;
+const unsigned bo_bad_score = 1;
+
+const unsigned pollution_filter_size = 4096;
+
+Stride_Table *initStrideTable()
+{
+    Stride_Table *table = (Stride_Table *)malloc(sizeof(Stride_Table));
+    table->num_entries = stride_table_size;
+    table->entries = (Stride_Entry *)calloc(stride_table_size, sizeof(Stride_Entry));
+    return table;
+}
+
+Stream_Table *initStreamTable()
+{
+    Stream_Table *table = (Stream_Table *)malloc(sizeof(Stream_Table));
+    table->num_entries = stream_table_size;
+    table->entries = (Stream_Entry *)calloc(stream_table_size, sizeof(Stream_Entry));
+    table->time = 0;
+    return table;
+}
+
+Best_Offset *initBestOffset()
+{
+    Best_Offset *bo = (Best_Offset *)malloc(sizeof(Best_Offset));
+
+    // Offsets of the form 2^i * 3^j * 5^k, as in the original proposal
+    bo->offsets = (int *)malloc(bo_max_offset * sizeof(int));
+    bo->num_offsets = 0;
+    for (unsigned n = 1; n <= bo_max_offset; n++)
+    {
+        unsigned m = n;
+        while (m % 2 == 0) m /= 2;
+        while (m % 3 == 0) m /= 3;
+        while (m % 5 == 0) m /= 5;
+        if (m == 1)
+        {
+            bo->offsets[bo->num_offsets++] = n;
+        }
+    }
+    bo->scores = (unsigned *)calloc(bo->num_offsets, sizeof(unsigned));
+
+    bo->rr_size = bo_rr_size;
+    bo->recent_requests = (uint64_t *)malloc(bo_rr_size * sizeof(uint64_t));
+    for (unsigned i = 0; i < bo_rr_size; i++)
+    {
+        bo->recent_requests[i] = UINT64_MAX;
+    }
+
+    bo->test_idx = 0;
+    bo->round = 0;
+    bo->best_offset = 1; // Behave like next-line until the first learning phase ends
+
+    return bo;
+}
+
+Prefetcher *initPrefetchers(unsigned *num_prefetchers)
+{
+    Prefetcher *prefetchers = (Prefetcher *)calloc(4, sizeof(Prefetcher));
+    unsigned n = 0;
+
+    #ifdef NEXT_LINE_PREFETCHER
+    prefetchers[n++].type = NEXT_LINE;
+    #endif
+
+    #ifdef STRIDE_PREFETCHER
+    prefetchers[n].type = STRIDE;
+    prefetchers[n++].stride = initStrideTable();
+    #endif
+
+    #ifdef STREAM_PREFETCHER
+    prefetchers[n].type = STREAM;
+    prefetchers[n++].stream = initStreamTable();
+    #endif
+
+    #ifdef BEST_OFFSET_PREFETCHER
+    prefetchers[n].type = BEST_OFFSET;
+    prefetchers[n++].best_offset = initBestOffset();
+    #endif
+
+    *num_prefetchers = n;
+    return prefetchers;
+}
+
+unsigned strideOperate(Stride_Table *table, Request *req, uint64_t blk_addr, uint64_t *candidates)
+{
+    Stride_Entry *entry = &table->entries[(req->PC ^ (req->PC >> 8)) % table->num_entries];
+
+    if (entry->PC != req->PC)
+    {
+        // New load, start training from scratch
+        entry->PC = req->PC;
+        entry->last_addr = blk_addr;
+        entry->stride = 0;
+        entry->confidence = 0;
+        return 0;
+    }
+
+    int64_t stride = (int64_t)(blk_addr - entry->last_addr);
+    entry->last_addr = blk_addr;
+
+    if (stride == 0)
+    {
+        return 0; // Same block again, nothing to learn
+    }
+
+    if (stride == entry->stride)
+    {
+        if (entry->confidence < stride_max_confidence)
+        {
+            entry->confidence++;
+        }
+    }
+    else
+    {
+        if (entry->confidence > 0)
+        {
+            entry->confidence--;
+        }
+        else
+        {
+            entry->stride = stride;
+        }
+        return 0;
+    }
+
+    if (entry->confidence < stride_threshold)
+    {
+        return 0;
+    }
+
+    unsigned n = 0;
+    for (unsigned k = 1; k <= stride_degree; k++)
+    {
+        candidates[n++] = blk_addr + (uint64_t)(entry->stride * (int64_t)k);
+    }
+    return n;
+}
+
+unsigned streamOperate(Stream_Table *table, uint64_t blk_addr, uint64_t *candidates)
+{
+    uint64_t region = blk_addr >> stream_region_shift;
+    table->time++;
+
+    // Find the stream this block continues, or the least recently used slot
+    Stream_Entry *entry = NULL;
+    Stream_Entry *lru = &table->entries[0];
+    for (unsigned i = 0; i < table->num_entries; i++)
+    {
+        Stream_Entry *e = &table->entries[i];
+        int64_t delta = (int64_t)(blk_addr - e->last_blk);
+        if (e->valid && (e->region == region || (delta >= -stream_window && delta <= stream_window)))
+        {
+            entry = e;
+            break;
+        }
+
+        if (!e->valid || e->lru < lru->lru)
+        {
+            lru = e;
+        }
+    }
+
+    if (entry == NULL)
+    {
+        lru->valid = true;
+        lru->region = region;
+        lru->last_blk = blk_addr;
+        lru->direction = 0;
+        lru->confirmations = 0;
+        lru->lru = table->time;
+        return 0;
+    }
+
+    int64_t delta = (int64_t)(blk_addr - entry->last_blk);
+    int direction = delta > 0 ? 1 : (delta < 0 ? -1 : 0);
+    if (direction != 0)
+    {
+        if (direction == entry->direction)
+        {
+            entry->confirmations++;
+        }
+        else
+        {
+            entry->direction = direction;
+            entry->confirmations = 1;
+        }
+        entry->last_blk = blk_addr;
+        entry->region = region;
+    }
+    entry->lru = table->time;
+
+    if (entry->confirmations < 2)
+    {
+        return 0;
+    }
+
+    unsigned n = 0;
+    for (unsigned k = 1; k <= stream_degree; k++)
+    {
+        candidates[n++] = blk_addr + (uint64_t)((int64_t)entry->direction * (int64_t)k);
+    }
+    return n;
+}
+
+bool inRecentRequests(Best_Offset *bo, uint64_t blk_num)
+{
+    return bo->recent_requests[blk_num % bo->rr_size] == blk_num;
+}
+
+void insertRecentRequest(Best_Offset *bo, uint64_t blk_num)
+{
+    bo->recent_requests[blk_num % bo->rr_size] = blk_num;
+}
+
+unsigned bestOffsetOperate(Best_Offset *bo, uint64_t blk_num, uint64_t *candidates)
+{
+    // Learning: would the offset under test have prefetched this block in time?
+    int offset = bo->offsets[bo->test_idx];
+    if (blk_num >= (uint64_t)offset && inRecentRequests(bo, blk_num - offset))
+    {
+        bo->scores[bo->test_idx]++;
+    }
+
+    bool end_phase = bo->scores[bo->test_idx] >= bo_score_max;
+    if (++bo->test_idx == bo->num_offsets)
+    {
+        bo->test_idx = 0;
+        end_phase = end_phase || ++bo->round >= bo_round_max;
+    }
+
+    if (end_phase)
+    {
+        unsigned best = 0;
+        for (unsigned i = 1; i < bo->num_offsets; i++)
+        {
+            if (bo->scores[i] > bo->scores[best])
+            {
+                best = i;
+            }
+        }
+        bo->best_offset = bo->scores[best] > bo_bad_score ? bo->offsets[best] : 0;
+
+        for (unsigned i = 0; i < bo->num_offsets; i++)
+        {
+            bo->scores[i] = 0;
+        }
+        bo->test_idx = 0;
+        bo->round = 0;
+    }
+
+    if (bo->best_offset == 0)
+    {
+        // Prefetching is off; keep learning from demand fills
+        insertRecentRequest(bo, blk_num);
+        return 0;
+    }
+
+    candidates[0] = blk_num + bo->best_offset;
+    return 1;
+}
+
+// Candidate block addresses for a triggering access to blk_addr
+unsigned prefetcherOperate(Prefetcher *prefetcher, Request *req, uint64_t blk_addr,
+                           unsigned blk_shift, uint64_t *candidates)
+{
+    uint64_t blk_num = blk_addr >> blk_shift;
+    unsigned n = 0;
+
+    switch (prefetcher->type)
+    {
+        case NEXT_LINE:
+            for (unsigned k = 1; k <= next_line_degree; k++)
+            {
+                candidates[n++] = blk_num + k;
+            }
+            break;
+        case STRIDE:
+            n = strideOperate(prefetcher->stride, req, blk_num, candidates);
+            break;
+        case STREAM:
+            n = streamOperate(prefetcher->stream, blk_num, candidates);
+            break;
+        case BEST_OFFSET:
+            n = bestOffsetOperate(prefetcher->best_offset, blk_num, candidates);
+            break;
+    }
+
+    assert(n <= MAX_PREFETCH_DEGREE);
+    for (unsigned i = 0; i < n; i++)
+    {
+        candidates[i] <<= blk_shift;
+    }
+    return n;
+}
+
+// A prefetch issued by this prefetcher has been inserted into the cache
+void prefetchFilled(Prefetcher *prefetcher, uint64_t blk_addr, unsigned blk_shift)
+{
+    if (prefetcher->type == BEST_OFFSET)
+    {
+        Best_Offset *bo = prefetcher->best_offset;
+        insertRecentRequest(bo, (blk_addr >> blk_shift) - bo->best_offset);
+    }
+}
+
+const char *prefetcherName(Prefetcher_Type type)
+{
+    switch (type)
+    {
+        case NEXT_LINE: return "Next-line";
+        case STRIDE: return "Stride";
+        case STREAM: return "Stream";
+        case BEST_OFFSET: return "Best-offset";
+        default: return "?";
+    }
+}
+
+Pollution_Filter *initPollutionFilter()
+{
+    Pollution_Filter *filter = (Pollution_Filter *)malloc(sizeof(Pollution_Filter));
+    filter->size = pollution_filter_size;
+    filter->blk_addrs = (uint64_t *)malloc(pollution_filter_size * sizeof(uint64_t));
+    filter->prefetcher_ids = (int *)malloc(pollution_filter_size * sizeof(int));
+
+    for (unsigned i = 0; i < pollution_filter_size; i++)
+    {
+        filter->blk_addrs[i] = UINT64_MAX;
+        filter->prefetcher_ids[i] = -1;
+    }
+
+    return filter;
+}
+
+void recordPollution(Pollution_Filter *filter, uint64_t blk_addr, int prefetcher_id)
+{
+    unsigned idx = (blk_addr ^ (blk_addr >> 12)) % filter->size;
+    filter->blk_addrs[idx] = blk_addr;
+    filter->prefetcher_ids[idx] = prefetcher_id;
+}
+
+// Which prefetcher evicted blk_addr, or -1 if none did
+int checkPollution(Pollution_Filter *filter, uint64_t blk_addr)
+{
+    unsigned idx = (blk_addr ^ (blk_addr >> 12)) % filter->size;
+    if (filter->blk_addrs[idx] != blk_addr)
+    {
+        return -1;
+    }
+
+    filter->blk_addrs[idx] = UINT64_MAX;
+    return filter->prefetcher_ids[idx];
+}
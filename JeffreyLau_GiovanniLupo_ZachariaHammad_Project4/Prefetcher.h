@@ -0,0 +1,115 @@
+#ifndef __PREFETCHER_H__
+#define __PREFETCHER_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Request.h"
+
+// Uncomment the prefetchers you want to attach to the cache (any combination)
+//#define NEXT_LINE_PREFETCHER
+//#define STRIDE_PREFETCHER
+//#define STREAM_PREFETCHER
+//#define BEST_OFFSET_PREFETCHER
+
+#if defined(NEXT_LINE_PREFETCHER) || defined(STRIDE_PREFETCHER) || \
+    defined(STREAM_PREFETCHER) || defined(BEST_OFFSET_PREFETCHER)
+#define PREFETCHING
+#endif
+
+#define MAX_PREFETCH_DEGREE 8
+
+typedef enum Prefetcher_Type{NEXT_LINE, STRIDE, STREAM, BEST_OFFSET}Prefetcher_Type;
+
+typedef struct Prefetcher_Stats
+{
+    uint64_t issued; // Prefetches that filled a block
+    uint64_t useful; // Prefetched blocks later hit by a demand request
+    uint64_t late; // Useful prefetches hit before the fill could have completed
+    uint64_t useless; // Prefetched blocks evicted without a demand hit
+    uint64_t pollution; // Demand misses on blocks a prefetch had evicted
+} Prefetcher_Stats;
+
+/* PC-indexed stride prefetcher (reference prediction table) */
+typedef struct Stride_Entry
+{
+    uint64_t PC;
+    uint64_t last_addr;
+    int64_t stride;
+    uint8_t confidence;
+} Stride_Entry;
+
+typedef struct Stride_Table
+{
+    Stride_Entry *entries;
+    unsigned num_entries;
+} Stride_Table;
+
+/* Stream prefetcher: tracks ascending/descending miss streams within a region */
+typedef struct Stream_Entry
+{
+    bool valid;
+    uint64_t region; // Region the stream lives in
+    uint64_t last_blk; // Last block number seen in the stream
+    int direction; // +1 or -1, 0 while still training
+    uint8_t confirmations;
+    uint64_t lru; // Last time this stream was touched
+} Stream_Entry;
+
+typedef struct Stream_Table
+{
+    Stream_Entry *entries;
+    unsigned num_entries;
+    uint64_t time;
+} Stream_Table;
+
+/* Best-offset prefetcher (Michaud, HPCA 2016) */
+typedef struct Best_Offset
+{
+    int *offsets; // Candidate offsets, in blocks
+    unsigned *scores;
+    unsigned num_offsets;
+
+    uint64_t *recent_requests; // Direct-mapped table of recently filled block numbers
+    unsigned rr_size;
+
+    unsigned test_idx; // Offset tested by the next access
+    unsigned round;
+
+    int best_offset; // Offset in use, 0 when prefetching is turned off
+} Best_Offset;
+
+typedef struct Prefetcher
+{
+    Prefetcher_Type type;
+    Prefetcher_Stats stats;
+
+    // State of this prefetcher type, the others are NULL
+    Stride_Table *stride;
+    Stream_Table *stream;
+    Best_Offset *best_offset;
+} Prefetcher;
+
+/* Remembers blocks that prefetches pushed out, to catch the misses they cause */
+typedef struct Pollution_Filter
+{
+    uint64_t *blk_addrs;
+    int *prefetcher_ids;
+    unsigned size;
+} Pollution_Filter;
+
+// Function Definitions
+Prefetcher *initPrefetchers(unsigned *num_prefetchers);
+unsigned prefetcherOperate(Prefetcher *prefetcher, Request *req, uint64_t blk_addr,
+                           unsigned blk_shift, uint64_t *candidates);
+void prefetchFilled(Prefetcher *prefetcher, uint64_t blk_addr, unsigned blk_shift);
+const char *prefetcherName(Prefetcher_Type type);
+
+Pollution_Filter *initPollutionFilter();
+void recordPollution(Pollution_Filter *filter, uint64_t blk_addr, int prefetcher_id);
+int checkPollution(Pollution_Filter *filter, uint64_t blk_addr);
+
+#endif /* __PREFETCHER_H__ */
@@ -0,0 +1,488 @@
+#include "Profiler.h"
+
+/* Constants */
+const unsigned profile_blk_shift = 6; // Reuse is measured at 64B block granularity
+const double shards_rate = 0.1; // Initial SHARDS sampling rate
+const unsigned shards_max_tracked = 1 << 16; // Bound on the sampled blocks kept in memory
+const uint64_t ws_window_size = 1000; // Requests per working-set window
+const unsigned max_profiled_pcs = 4096;
+
+const char *rd_csv_file = "reuse_distance.csv";
+const char *ws_csv_file = "working_set.csv";
+
+uint32_t hashProfiledBlock(uint64_t blk_addr)
+{
+    blk_addr ^= blk_addr >> 33;
+    blk_addr *= 0xff51afd7ed558ccdULL;
+    blk_addr ^= blk_addr >> 33;
+    blk_addr *= 0xc4ceb9fe1a85ec53ULL;
+    blk_addr ^= blk_addr >> 33;
+    return (uint32_t)(blk_addr >> 32);
+}
+
+/* Treap */
+uint32_t treapSize(Treap *treap, int node)
+{
+    return node < 0 ? 0 : treap->nodes[node].size;
+}
+
+void treapUpdate(Treap *treap, int node)
+{
+    Treap_Node *n = &treap->nodes[node];
+    n->size = 1 + treapSize(treap, n->left) + treapSize(treap, n->right);
+}
+
+// Split into keys < key and keys >= key
+void treapSplit(Treap *treap, int node, uint64_t key, int *left, int *right)
+{
+    if (node < 0)
+    {
+        *left = -1;
+        *right = -1;
+        return;
+    }
+
+    if (treap->nodes[node].key < key)
+    {
+        treapSplit(treap, treap->nodes[node].right, key, &treap->nodes[node].right, right);
+        *left = node;
+    }
+    else
+    {
+        treapSplit(treap, treap->nodes[node].left, key, left, &treap->nodes[node].left);
+        *right = node;
+    }
+    treapUpdate(treap, node);
+}
+
+int treapMerge(Treap *treap, int left, int right)
+{
+    if (left < 0 || right < 0)
+    {
+        return left < 0 ? right : left;
+    }
+
+    if (treap->nodes[left].priority > treap->nodes[right].priority)
+    {
+        treap->nodes[left].right = treapMerge(treap, treap->nodes[left].right, right);
+        treapUpdate(treap, left);
+        return left;
+    }
+
+    treap->nodes[right].left = treapMerge(treap, left, treap->nodes[right].left);
+    treapUpdate(treap, right);
+    return right;
+}
+
+void treapInsert(Treap *treap, uint64_t key)
+{
+    if (treap->free_list < 0)
+    {
+        // Indices stay valid across the resize
+        unsigned old_capacity = treap->capacity;
+        treap->capacity *= 2;
+        treap->nodes = (Treap_Node *)realloc(treap->nodes, treap->capacity * sizeof(Treap_Node));
+        for (unsigned i = old_capacity; i < treap->capacity; i++)
+        {
+            treap->nodes[i].left = i + 1 < treap->capacity ? (int)(i + 1) : -1;
+        }
+        treap->free_list = old_capacity;
+    }
+
+    int node = treap->free_list;
+    treap->free_list = treap->nodes[node].left;
+
+    static uint32_t seed = 2463534242u;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    treap->nodes[node].key = key;
+    treap->nodes[node].priority = seed;
+    treap->nodes[node].size = 1;
+    treap->nodes[node].left = -1;
+    treap->nodes[node].right = -1;
+
+    int left, right;
+    treapSplit(treap, treap->root, key, &left, &right);
+    treap->root = treapMerge(treap, treapMerge(treap, left, node), right);
+}
+
+void treapErase(Treap *treap, uint64_t key)
+{
+    int left, mid, right;
+    treapSplit(treap, treap->root, key, &left, &right);
+    treapSplit(treap, right, key + 1, &mid, &right);
+
+    assert(mid >= 0 && treap->nodes[mid].size == 1);
+    treap->nodes[mid].left = treap->free_list;
+    treap->free_list = mid;
+
+    treap->root = treapMerge(treap, left, right);
+}
+
+// Number of keys greater than key
+uint64_t treapCountGreater(Treap *treap, uint64_t key)
+{
+    uint64_t count = 0;
+    int node = treap->root;
+
+    while (node >= 0)
+    {
+        if (treap->nodes[node].key > key)
+        {
+            count += treapSize(treap, treap->nodes[node].right) + 1;
+            node = treap->nodes[node].left;
+        }
+        else
+        {
+            node = treap->nodes[node].right;
+        }
+    }
+
+    return count;
+}
+
+/* Sampled block map (linear probing with backward-shift deletion) */
+Profiled_Block *findProfiledBlock(Reuse_Profiler *profiler, uint64_t blk_addr, uint32_t hash)
+{
+    uint64_t mask = profiler->capacity - 1;
+    uint64_t slot = hash & mask;
+
+    while (profiler->blocks[slot].blk_addr != UINT64_MAX)
+    {
+        if (profiler->blocks[slot].blk_addr == blk_addr)
+        {
+            return &profiler->blocks[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return &profiler->blocks[slot];
+}
+
+void allocProfiledBlocks(Reuse_Profiler *profiler, uint64_t capacity)
+{
+    profiler->capacity = capacity;
+    profiler->blocks = (Profiled_Block *)malloc(capacity * sizeof(Profiled_Block));
+    for (uint64_t i = 0; i < capacity; i++)
+    {
+        profiler->blocks[i].blk_addr = UINT64_MAX;
+    }
+}
+
+// Rehash into a table of the given capacity, keeping only blocks that are still sampled
+void rebuildProfiledBlocks(Reuse_Profiler *profiler, uint64_t capacity)
+{
+    Profiled_Block *old_blocks = profiler->blocks;
+    uint64_t old_capacity = profiler->capacity;
+
+    allocProfiledBlocks(profiler, capacity);
+    profiler->tracked = 0;
+
+    for (uint64_t i = 0; i < old_capacity; i++)
+    {
+        Profiled_Block *blk = &old_blocks[i];
+        if (blk->blk_addr == UINT64_MAX)
+        {
+            continue;
+        }
+
+        if (blk->hash >= profiler->threshold)
+        {
+            treapErase(&profiler->treap, blk->last_time);
+            continue;
+        }
+
+        *findProfiledBlock(profiler, blk->blk_addr, blk->hash) = *blk;
+        profiler->tracked++;
+    }
+
+    free(old_blocks);
+}
+
+// SHARDS fixed-size: sample less when too many blocks are being tracked
+void lowerSamplingRate(Reuse_Profiler *profiler)
+{
+    while (profiler->tracked > profiler->max_tracked)
+    {
+        profiler->threshold = (uint32_t)(profiler->threshold * 0.9);
+        profiler->rate = (double)profiler->threshold / 4294967296.0;
+        rebuildProfiledBlocks(profiler, profiler->capacity);
+    }
+}
+
+/* Per-PC map */
+PC_Profile *findPCProfile(Reuse_Profiler *profiler, uint64_t PC)
+{
+    unsigned mask = profiler->pc_capacity - 1;
+    unsigned slot = (unsigned)((PC ^ (PC >> 17)) & mask);
+
+    while (profiler->pcs[slot].PC != UINT64_MAX)
+    {
+        if (profiler->pcs[slot].PC == PC)
+        {
+            return &profiler->pcs[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (profiler->num_pcs == max_profiled_pcs)
+    {
+        return NULL; // Table full, account under "other"
+    }
+
+    PC_Profile *pc = &profiler->pcs[slot];
+    pc->PC = PC;
+    for (unsigned i = 0; i < RD_BUCKETS; i++)
+    {
+        pc->histogram[i] = 0;
+    }
+    pc->window_blocks = 0;
+    profiler->num_pcs++;
+
+    return pc;
+}
+
+Reuse_Profiler *initReuseProfiler()
+{
+    Reuse_Profiler *profiler = (Reuse_Profiler *)calloc(1, sizeof(Reuse_Profiler));
+
+    profiler->rate = shards_rate;
+    profiler->threshold = (uint32_t)(shards_rate * 4294967295.0);
+    profiler->max_tracked = shards_max_tracked;
+
+    allocProfiledBlocks(profiler, 1024);
+    profiler->tracked = 0;
+
+    profiler->treap.capacity = 1024;
+    profiler->treap.nodes = (Treap_Node *)malloc(profiler->treap.capacity * sizeof(Treap_Node));
+    for (unsigned i = 0; i < profiler->treap.capacity; i++)
+    {
+        profiler->treap.nodes[i].left = i + 1 < profiler->treap.capacity ? (int)(i + 1) : -1;
+    }
+    profiler->treap.free_list = 0;
+    profiler->treap.root = -1;
+
+    profiler->pc_capacity = 2 * max_profiled_pcs;
+    profiler->pcs = (PC_Profile *)malloc(profiler->pc_capacity * sizeof(PC_Profile));
+    for (unsigned i = 0; i < profiler->pc_capacity; i++)
+    {
+        profiler->pcs[i].PC = UINT64_MAX;
+    }
+
+    profiler->window_size = ws_window_size;
+    profiler->ws_fd = fopen(ws_csv_file, "w");
+    assert(profiler->ws_fd != NULL);
+    fprintf(profiler->ws_fd, "window,scope,id,blocks\n");
+
+    return profiler;
+}
+
+// Write the working set of the window that just ended
+void flushWindow(Reuse_Profiler *profiler)
+{
+    fprintf(profiler->ws_fd, "%"PRIu64",all,-,%.0lf\n", profiler->window, profiler->window_blocks);
+    profiler->window_blocks = 0;
+
+    for (unsigned c = 0; c < MAX_PROFILED_CORES; c++)
+    {
+        if (profiler->core_window_blocks[c] > 0)
+        {
+            fprintf(profiler->ws_fd, "%"PRIu64",core,%u,%.0lf\n", profiler->window, c,
+                    profiler->core_window_blocks[c]);
+            profiler->core_window_blocks[c] = 0;
+        }
+    }
+
+    for (unsigned i = 0; i < profiler->pc_capacity; i++)
+    {
+        PC_Profile *pc = &profiler->pcs[i];
+        if (pc->PC != UINT64_MAX && pc->window_blocks > 0)
+        {
+            fprintf(profiler->ws_fd, "%"PRIu64",pc,%"PRIu64",%.0lf\n", profiler->window, pc->PC,
+                    pc->window_blocks);
+            pc->window_blocks = 0;
+        }
+    }
+}
+
+unsigned distanceBucket(double distance)
+{
+    if (distance < 1)
+    {
+        return 0;
+    }
+
+    unsigned bucket = (unsigned)log2(distance) + 1;
+    return bucket < RD_BUCKETS - 1 ? bucket : RD_BUCKETS - 2;
+}
+
+void profileRequest(Reuse_Profiler *profiler, Request *req)
+{
+    uint64_t window = profiler->num_reqs / profiler->window_size;
+    if (window != profiler->window)
+    {
+        flushWindow(profiler);
+        profiler->window = window;
+    }
+    profiler->num_reqs++;
+
+    uint64_t blk_addr = req->load_or_store_addr >> profile_blk_shift << profile_blk_shift;
+    uint32_t hash = hashProfiledBlock(blk_addr);
+    if (hash >= profiler->threshold)
+    {
+        return; // Not sampled
+    }
+    profiler->sampled_reqs++;
+
+    double weight = 1.0 / profiler->rate;
+    unsigned core = (unsigned)req->core_id < MAX_PROFILED_CORES ? (unsigned)req->core_id : MAX_PROFILED_CORES - 1;
+    PC_Profile *pc = findPCProfile(profiler, req->PC);
+
+    // Step one: reuse distance = distinct sampled blocks touched since the last access
+    if (2 * (profiler->tracked + 1) > profiler->capacity)
+    {
+        rebuildProfiledBlocks(profiler, profiler->capacity * 2);
+    }
+
+    Profiled_Block *blk = findProfiledBlock(profiler, blk_addr, hash);
+    unsigned bucket;
+    if (blk->blk_addr == blk_addr)
+    {
+        uint64_t distance = treapCountGreater(&profiler->treap, blk->last_time);
+        bucket = distanceBucket((double)distance / profiler->rate);
+        treapErase(&profiler->treap, blk->last_time);
+    }
+    else
+    {
+        bucket = RD_BUCKETS - 1; // Cold
+        blk->blk_addr = blk_addr;
+        blk->hash = hash;
+        blk->last_window = UINT64_MAX;
+        blk->window_cores = 0;
+        profiler->tracked++;
+    }
+
+    profiler->histogram[bucket] += weight;
+    profiler->core_histogram[core][bucket] += weight;
+    if (pc != NULL)
+    {
+        pc->histogram[bucket] += weight;
+    }
+    else
+    {
+        profiler->other_pc_histogram[bucket] += weight;
+    }
+
+    blk->last_time = profiler->time;
+    treapInsert(&profiler->treap, profiler->time);
+    profiler->time++;
+
+    // Step two: working set of the current window
+    if (blk->last_window != profiler->window)
+    {
+        blk->last_window = profiler->window;
+        blk->window_cores = 0;
+
+        profiler->window_blocks += weight;
+        if (pc != NULL)
+        {
+            pc->window_blocks += weight; // Charged to the PC that touches it first
+        }
+    }
+
+    if (!((blk->window_cores >> core) & 1))
+    {
+        blk->window_cores |= (uint32_t)1 << core;
+        profiler->core_window_blocks[core] += weight;
+    }
+
+    if (profiler->tracked > profiler->max_tracked)
+    {
+        lowerSamplingRate(profiler);
+    }
+}
+
+void writeHistogram(FILE *fd, const char *scope, const char *id, double *histogram)
+{
+    for (unsigned b = 0; b < RD_BUCKETS; b++)
+    {
+        if (histogram[b] <= 0)
+        {
+            continue;
+        }
+
+        if (b == RD_BUCKETS - 1)
+        {
+            fprintf(fd, "%s,%s,cold,cold,%.0lf\n", scope, id, histogram[b]);
+        }
+        else
+        {
+            uint64_t lo = b == 0 ? 0 : (uint64_t)1 << (b - 1);
+            uint64_t hi = (uint64_t)1 << b;
+            fprintf(fd, "%s,%s,%"PRIu64",%"PRIu64",%.0lf\n", scope, id, lo, hi, histogram[b]);
+        }
+    }
+}
+
+void dumpReuseProfile(Reuse_Profiler *profiler)
+{
+    flushWindow(profiler);
+    fclose(profiler->ws_fd);
+
+    // Summary
+    double total = 0;
+    for (unsigned b = 0; b < RD_BUCKETS; b++)
+    {
+        total += profiler->histogram[b];
+    }
+
+    printf("Reuse profile: %"PRIu64" requests, %"PRIu64" sampled (final rate %lf, %"PRIu64" blocks tracked)\n",
+           profiler->num_reqs, profiler->sampled_reqs, profiler->rate, profiler->tracked);
+    for (unsigned b = 0; b < RD_BUCKETS; b++)
+    {
+        if (profiler->histogram[b] <= 0)
+        {
+            continue;
+        }
+
+        if (b == RD_BUCKETS - 1)
+        {
+            printf("  Reuse distance cold: %.0lf (%.2lf%%)\n",
+                   profiler->histogram[b], profiler->histogram[b] / total * 100);
+        }
+        else
+        {
+            printf("  Reuse distance [%"PRIu64", %"PRIu64"): %.0lf (%.2lf%%)\n",
+                   b == 0 ? 0 : (uint64_t)1 << (b - 1), (uint64_t)1 << b,
+                   profiler->histogram[b], profiler->histogram[b] / total * 100);
+        }
+    }
+
+    // Full per-core and per-PC histograms
+    FILE *fd = fopen(rd_csv_file, "w");
+    assert(fd != NULL);
+    fprintf(fd, "scope,id,distance_min,distance_max,count\n");
+    writeHistogram(fd, "all", "-", profiler->histogram);
+
+    char id[32];
+    for (unsigned c = 0; c < MAX_PROFILED_CORES; c++)
+    {
+        snprintf(id, sizeof(id), "%u", c);
+        writeHistogram(fd, "core", id, profiler->core_histogram[c]);
+    }
+
+    for (unsigned i = 0; i < profiler->pc_capacity; i++)
+    {
+        if (profiler->pcs[i].PC != UINT64_MAX)
+        {
+            snprintf(id, sizeof(id), "%"PRIu64, profiler->pcs[i].PC);
+            writeHistogram(fd, "pc", id, profiler->pcs[i].histogram);
+        }
+    }
+    writeHistogram(fd, "pc", "other", profiler->other_pc_histogram);
+    fclose(fd);
+
+    printf("  Histograms written to %s, working-set curves to %s\n", rd_csv_file, ws_csv_file);
+}
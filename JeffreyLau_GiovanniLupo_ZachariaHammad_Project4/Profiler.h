@@ -0,0 +1,94 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "Request.h"
+
+// Uncomment to profile reuse distance and working set while simulating
+//#define REUSE_PROFILER
+
+#define RD_BUCKETS 48 // Log2 reuse-distance buckets, the last one holds cold misses
+#define MAX_PROFILED_CORES 32
+
+/* A sampled block */
+typedef struct Profiled_Block
+{
+    uint64_t blk_addr; // UINT64_MAX marks an empty slot
+    uint64_t last_time; // Last (sampled) access to this block
+    uint32_t hash;
+    uint64_t last_window; // Working-set window of the last access
+    uint32_t window_cores; // Cores that touched the block in last_window
+} Profiled_Block;
+
+/* Order-statistic treap over last-access times */
+typedef struct Treap_Node
+{
+    uint64_t key;
+    uint32_t priority;
+    uint32_t size;
+    int left;
+    int right;
+} Treap_Node;
+
+typedef struct Treap
+{
+    Treap_Node *nodes;
+    unsigned capacity;
+    int root;
+    int free_list; // Linked through the left child
+} Treap;
+
+/* Per-PC counters */
+typedef struct PC_Profile
+{
+    uint64_t PC; // UINT64_MAX marks an empty slot
+    double histogram[RD_BUCKETS];
+    double window_blocks; // Distinct blocks first touched by this PC in the current window
+} PC_Profile;
+
+typedef struct Reuse_Profiler
+{
+    /* SHARDS sampling */
+    uint32_t threshold; // Blocks whose hash is below threshold are sampled
+    double rate; // threshold / 2^32
+    unsigned max_tracked; // Lower the rate when more blocks than this are tracked
+
+    Profiled_Block *blocks; // Open-addressing map of sampled blocks
+    uint64_t capacity;
+    uint64_t tracked;
+
+    Treap treap;
+    uint64_t time;
+
+    /* Reuse distance, weighted by 1 / rate */
+    double histogram[RD_BUCKETS];
+    double core_histogram[MAX_PROFILED_CORES][RD_BUCKETS];
+
+    PC_Profile *pcs; // Open-addressing map
+    unsigned pc_capacity;
+    unsigned num_pcs;
+    double other_pc_histogram[RD_BUCKETS]; // PCs that did not fit
+
+    /* Working set */
+    uint64_t window; // Current window id
+    uint64_t window_size; // Requests per window
+    double window_blocks;
+    double core_window_blocks[MAX_PROFILED_CORES];
+    FILE *ws_fd;
+
+    uint64_t num_reqs;
+    uint64_t sampled_reqs;
+} Reuse_Profiler;
+
+// Function Definitions
+Reuse_Profiler *initReuseProfiler();
+void profileRequest(Reuse_Profiler *profiler, Request *req);
+void dumpReuseProfile(Reuse_Profiler *profiler);
+
+#endif /* __PROFILER_H__ */
@@ -3,8 +3,12 @@
 
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h> // uint64_t
+#include <stdbool.h>
 
-typedef enum Request_Type{LOAD, STORE}Request_Type;
+#define REQUEST_DATA_SIZE 64 // Bytes of block contents an optional trace field carries
+
+// WRITEBACK is a dirty eviction from an upper-level cache
+typedef enum Request_Type{LOAD, STORE, WRITEBACK}Request_Type;
 
 // Instruction Format
 typedef struct Request
@@ -18,6 +22,13 @@ typedef struct Request
 
     int core_id; // The core of PC is running on
 
+    uint64_t next_use; // Index of the next request to the same block (OPT only)
+
+    int prefetcher_id; // Which prefetcher issued this request, -1 for demand requests
+
+    bool has_data; // Did the trace carry the block contents?
+    uint8_t data[REQUEST_DATA_SIZE]; // Block contents after this access
+
 }Request;
 
 #endif
@@ -0,0 +1,466 @@
+#include "Cache.h"
+
+/* Constants */
+const unsigned drrip_leader_sets = 32; // Leader sets per competing policy
+const unsigned drrip_psel_bits = 10;
+const unsigned brrip_epsilon = 32; // BRRIP inserts at max_rrpv - 1 once every 32 fills
+
+const unsigned ship_pp_table_size = 16384; // 14-bit signatures
+const unsigned ship_pp_counter_bits = 3;
+
+const unsigned hawkeye_sample_shift = 3; // Sample one out of every 8 sets
+const unsigned hawkeye_history = 8; // OPTgen window, in multiples of the associativity
+const unsigned hawkeye_table_size = 8192;
+const unsigned hawkeye_counter_bits = 3;
+const uint8_t hawkeye_max_rrpv = 7; // Hawkeye uses 3-bit RRPVs
+
+/* DRRIP */
+Drrip *initDrrip(unsigned num_sets)
+{
+    Drrip *drrip = (Drrip *)malloc(sizeof(Drrip));
+
+    // Spread the leaders evenly; small caches dedicate a quarter of their sets
+    unsigned leaders = drrip_leader_sets;
+    if (leaders > num_sets / 8)
+    {
+        leaders = num_sets / 8 ? num_sets / 8 : 1;
+    }
+    drrip->leader_stride = num_sets / leaders;
+
+    drrip->psel_max = (1 << drrip_psel_bits) - 1;
+    drrip->psel = (drrip->psel_max + 1) / 2;
+    drrip->brrip_fills = 0;
+
+    return drrip;
+}
+
+bool isSrripLeader(Drrip *drrip, uint64_t set_idx)
+{
+    return set_idx % drrip->leader_stride == 0;
+}
+
+bool isBrripLeader(Drrip *drrip, uint64_t set_idx)
+{
+    return drrip->leader_stride > 1 && set_idx % drrip->leader_stride == drrip->leader_stride / 2;
+}
+
+/* SHiP++ */
+Ship_PP *initShipPP()
+{
+    Ship_PP *ship_pp = (Ship_PP *)malloc(sizeof(Ship_PP));
+    ship_pp->table_size = ship_pp_table_size;
+    ship_pp->max_counter = (1 << ship_pp_counter_bits) - 1;
+    ship_pp->shct = (uint8_t *)malloc(ship_pp_table_size * sizeof(uint8_t));
+
+    // Start weakly re-referenced, as SHiP++ does
+    for (unsigned i = 0; i < ship_pp_table_size; i++)
+    {
+        ship_pp->shct[i] = 1;
+    }
+
+    return ship_pp;
+}
+
+// PC and core hashed together, so the same code on two cores trains separately
+uint32_t shipPPSignature(Ship_PP *ship_pp, uint64_t PC, int core_id)
+{
+    uint64_t signature = PC ^ (PC >> 14) ^ (PC >> 28) ^ ((uint64_t)core_id << 11);
+    return signature % ship_pp->table_size;
+}
+
+void trainShipPP(Ship_PP *ship_pp, uint32_t signature, bool reused)
+{
+    uint8_t *counter = &ship_pp->shct[signature];
+
+    if (reused)
+    {
+        if (*counter < ship_pp->max_counter)
+        {
+            (*counter)++;
+        }
+    }
+    else if (*counter > 0)
+    {
+        (*counter)--;
+    }
+}
+
+/* Hawkeye */
+Hawkeye *initHawkeye(unsigned num_sets, unsigned num_ways)
+{
+    Hawkeye *hawkeye = (Hawkeye *)malloc(sizeof(Hawkeye));
+
+    hawkeye->sample_shift = hawkeye_sample_shift;
+    hawkeye->num_sampled_sets = num_sets >> hawkeye_sample_shift;
+    if (hawkeye->num_sampled_sets == 0)
+    {
+        hawkeye->sample_shift = 0;
+        hawkeye->num_sampled_sets = num_sets;
+    }
+    hawkeye->num_ways = num_ways;
+    hawkeye->history = hawkeye_history * num_ways;
+
+    hawkeye->sampled_sets = (OPTgen_Set *)malloc(hawkeye->num_sampled_sets * sizeof(OPTgen_Set));
+    for (unsigned i = 0; i < hawkeye->num_sampled_sets; i++)
+    {
+        OPTgen_Set *set = &hawkeye->sampled_sets[i];
+        set->occupancy = (uint8_t *)calloc(hawkeye->history, sizeof(uint8_t));
+        set->time = 0;
+
+        set->num_entries = hawkeye->history;
+        set->tags = (uint64_t *)malloc(set->num_entries * sizeof(uint64_t));
+        set->last_time = (uint64_t *)calloc(set->num_entries, sizeof(uint64_t));
+        set->last_sig = (uint32_t *)calloc(set->num_entries, sizeof(uint32_t));
+        for (unsigned j = 0; j < set->num_entries; j++)
+        {
+            set->tags[j] = UINT64_MAX;
+        }
+    }
+
+    hawkeye->table_size = hawkeye_table_size;
+    hawkeye->max_counter = (1 << hawkeye_counter_bits) - 1;
+    hawkeye->predictor = (uint8_t *)malloc(hawkeye_table_size * sizeof(uint8_t));
+    for (unsigned i = 0; i < hawkeye_table_size; i++)
+    {
+        hawkeye->predictor[i] = (hawkeye->max_counter + 1) / 2; // Weakly friendly
+    }
+
+    hawkeye->opt_hits = 0;
+    hawkeye->opt_accesses = 0;
+
+    return hawkeye;
+}
+
+uint32_t hawkeyeSignature(Hawkeye *hawkeye, uint64_t PC, int core_id)
+{
+    uint64_t signature = PC ^ (PC >> 13) ^ (PC >> 26) ^ ((uint64_t)core_id << 10);
+    return signature % hawkeye->table_size;
+}
+
+bool hawkeyeFriendly(Hawkeye *hawkeye, uint32_t signature)
+{
+    return hawkeye->predictor[signature] > hawkeye->max_counter / 2;
+}
+
+void trainHawkeye(Hawkeye *hawkeye, uint32_t signature, bool opt_hit)
+{
+    uint8_t *counter = &hawkeye->predictor[signature];
+
+    if (opt_hit)
+    {
+        if (*counter < hawkeye->max_counter)
+        {
+            (*counter)++;
+        }
+    }
+    else if (*counter > 0)
+    {
+        (*counter)--;
+    }
+}
+
+// OPTgen: would Belady have hit on this access? Train the predictor on the answer.
+void hawkeyeAccess(Hawkeye *hawkeye, uint64_t set_idx, uint64_t blk_addr, uint32_t signature)
+{
+    if (set_idx & ((1 << hawkeye->sample_shift) - 1))
+    {
+        return; // Not a sampled set
+    }
+
+    OPTgen_Set *set = &hawkeye->sampled_sets[set_idx >> hawkeye->sample_shift];
+    uint64_t now = set->time;
+
+    // Look the block up in the sampler, remembering the oldest entry as a replacement
+    unsigned entry = set->num_entries;
+    unsigned oldest = 0;
+    for (unsigned i = 0; i < set->num_entries; i++)
+    {
+        if (set->tags[i] == blk_addr)
+        {
+            entry = i;
+            break;
+        }
+        if (set->tags[i] == UINT64_MAX || set->last_time[i] < set->last_time[oldest])
+        {
+            oldest = i;
+        }
+    }
+
+    if (entry != set->num_entries && now - set->last_time[entry] < hawkeye->history)
+    {
+        // Could the block have stayed cached since its last use?
+        bool opt_hit = true;
+        for (uint64_t t = set->last_time[entry]; t < now; t++)
+        {
+            if (set->occupancy[t % hawkeye->history] >= hawkeye->num_ways)
+            {
+                opt_hit = false;
+                break;
+            }
+        }
+
+        if (opt_hit)
+        {
+            for (uint64_t t = set->last_time[entry]; t < now; t++)
+            {
+                set->occupancy[t % hawkeye->history]++;
+            }
+            hawkeye->opt_hits++;
+        }
+
+        hawkeye->opt_accesses++;
+        trainHawkeye(hawkeye, set->last_sig[entry], opt_hit);
+    }
+    else if (entry != set->num_entries)
+    {
+        // Reused beyond the window OPTgen can see
+        hawkeye->opt_accesses++;
+        trainHawkeye(hawkeye, set->last_sig[entry], false);
+    }
+    else
+    {
+        entry = oldest;
+        set->tags[entry] = blk_addr;
+    }
+
+    set->last_time[entry] = now;
+    set->last_sig[entry] = signature;
+
+    set->occupancy[now % hawkeye->history] = 0; // A new quantum starts empty
+    set->time++;
+}
+
+/* Replacement Policies */
+
+// Find a block with RRPV == max_rrpv among the candidate ways, ageing them until one appears
+Cache_Block *rripVictim(Cache *cache, Cache_Block **ways, uint64_t candidates, uint8_t max_rrpv)
+{
+    while (true)
+    {
+        for (unsigned i = 0; i < cache->num_ways; i++)
+        {
+            if (((candidates >> i) & 1) && ways[i]->rrpv >= max_rrpv)
+            {
+                return ways[i];
+            }
+        }
+
+        for (unsigned i = 0; i < cache->num_ways; i++)
+        {
+            if (((candidates >> i) & 1) && ways[i]->rrpv < max_rrpv)
+            {
+                ways[i]->rrpv++;
+            }
+        }
+    }
+}
+
+bool drrip(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, Request *req)
+{
+    Drrip *drrip = cache->drrip;
+    uint8_t max_rrpv = cache->max_rrpv;
+
+    uint64_t set_idx = (addr >> cache->set_shift) & cache->set_mask;
+    Cache_Block **ways = cache->sets[set_idx].ways;
+
+    // Every call is a miss; charge it to the leader's policy
+    bool use_brrip;
+    if (isSrripLeader(drrip, set_idx))
+    {
+        if (drrip->psel < drrip->psel_max)
+        {
+            drrip->psel++;
+        }
+        use_brrip = false;
+    }
+    else if (isBrripLeader(drrip, set_idx))
+    {
+        if (drrip->psel > 0)
+        {
+            drrip->psel--;
+        }
+        use_brrip = true;
+    }
+    else
+    {
+        use_brrip = drrip->psel >= (drrip->psel_max + 1) / 2;
+    }
+
+    uint8_t initial_rrpv = max_rrpv - 1;
+    if (use_brrip && (drrip->brrip_fills++ % brrip_epsilon) != 0)
+    {
+        initial_rrpv = max_rrpv;
+    }
+
+    // Step one: try to find an invalid block.
+    Cache_Block *victim = NULL;
+    bool wb_required = false;
+    for (unsigned i = 0; i < cache->num_ways; i++)
+    {
+        if (ways[i]->valid == false)
+        {
+            victim = ways[i];
+            break;
+        }
+    }
+
+    // Step two: find a victim with RRPV == max_rrpv
+    if (victim == NULL)
+    {
+        victim = rripVictim(cache, ways, victimCandidates(cache, ways, req), max_rrpv);
+        wb_required = replaceBlock(cache, victim, wb_addr, req);
+    }
+
+    victim->rrpv = initial_rrpv;
+    victim->outcome = false;
+
+    *victim_blk = victim;
+    return wb_required;
+}
+
+bool ship_pp(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, Request *req)
+{
+    Ship_PP *ship_pp = cache->ship_pp;
+    uint8_t max_rrpv = cache->max_rrpv;
+
+    uint64_t set_idx = (addr >> cache->set_shift) & cache->set_mask;
+    Cache_Block **ways = cache->sets[set_idx].ways;
+
+    uint32_t signature = shipPPSignature(ship_pp, req->PC, req->core_id);
+
+    // Step one: try to find an invalid block.
+    Cache_Block *victim = NULL;
+    bool wb_required = false;
+    for (unsigned i = 0; i < cache->num_ways; i++)
+    {
+        if (ways[i]->valid == false)
+        {
+            victim = ways[i];
+            break;
+        }
+    }
+
+    // Step two: find a victim with RRPV == max_rrpv, training on blocks never reused
+    if (victim == NULL)
+    {
+        victim = rripVictim(cache, ways, victimCandidates(cache, ways, req), max_rrpv);
+
+        if (!victim->outcome && victim->signature != UINT64_MAX)
+        {
+            trainShipPP(ship_pp, (uint32_t)victim->signature, false);
+        }
+
+        wb_required = replaceBlock(cache, victim, wb_addr, req);
+    }
+
+    // Step three: writeback-aware insertion
+    if (req->req_type == WRITEBACK)
+    {
+        // Write-backs are rarely read again and must not train the predictor
+        victim->rrpv = max_rrpv;
+        victim->signature = UINT64_MAX;
+    }
+    else
+    {
+        uint8_t counter = ship_pp->shct[signature];
+        if (counter == 0)
+        {
+            victim->rrpv = max_rrpv;
+        }
+        else if (counter == ship_pp->max_counter)
+        {
+            victim->rrpv = 0; // High confidence of reuse
+        }
+        else
+        {
+            victim->rrpv = max_rrpv - 1;
+        }
+        victim->signature = signature;
+    }
+    victim->outcome = false;
+
+    *victim_blk = victim;
+    return wb_required;
+}
+
+bool hawkeye(Cache *cache, uint64_t addr, Cache_Block **victim_blk, uint64_t *wb_addr, Request *req)
+{
+    Hawkeye *hawkeye = cache->hawkeye;
+
+    uint64_t set_idx = (addr >> cache->set_shift) & cache->set_mask;
+    Cache_Block **ways = cache->sets[set_idx].ways;
+
+    uint32_t signature = hawkeyeSignature(hawkeye, req->PC, req->core_id);
+    bool friendly = hawkeyeFriendly(hawkeye, signature);
+
+    // Step one: try to find an invalid block.
+    Cache_Block *victim = NULL;
+    bool wb_required = false;
+    for (unsigned i = 0; i < cache->num_ways; i++)
+    {
+        if (ways[i]->valid == false)
+        {
+            victim = ways[i];
+            break;
+        }
+    }
+
+    uint64_t candidates = victimCandidates(cache, ways, req);
+
+    // Step two: evict a cache-averse block, or else the oldest friendly one
+    if (victim == NULL)
+    {
+        for (unsigned i = 0; i < cache->num_ways; i++)
+        {
+            if (!((candidates >> i) & 1))
+            {
+                continue;
+            }
+
+            if (victim == NULL || ways[i]->rrpv > victim->rrpv)
+            {
+                victim = ways[i];
+            }
+        }
+
+        if (victim->rrpv < hawkeye_max_rrpv)
+        {
+            // The predictor was wrong to call this block friendly
+            trainHawkeye(hawkeye, (uint32_t)victim->signature, false);
+        }
+
+        wb_required = replaceBlock(cache, victim, wb_addr, req);
+    }
+
+    // Step three: insert, ageing the other friendly blocks
+    if (friendly)
+    {
+        for (unsigned i = 0; i < cache->num_ways; i++)
+        {
+            if (ways[i] != victim && ways[i]->valid && ((candidates >> i) & 1) &&
+                ways[i]->rrpv < hawkeye_max_rrpv - 1)
+            {
+                ways[i]->rrpv++;
+            }
+        }
+        victim->rrpv = 0;
+    }
+    else
+    {
+        victim->rrpv = hawkeye_max_rrpv;
+    }
+    victim->signature = signature;
+    victim->outcome = false;
+
+    *victim_blk = victim;
+    return wb_required;
+}
+
+// Hit promotion for Hawkeye follows the prediction for the current PC
+void hawkeyeHit(Cache *cache, Cache_Block *blk, Request *req)
+{
+    uint32_t signature = hawkeyeSignature(cache->hawkeye, req->PC, req->core_id);
+
+    blk->signature = signature;
+    blk->rrpv = hawkeyeFriendly(cache->hawkeye, signature) ? 0 : hawkeye_max_rrpv;
+}
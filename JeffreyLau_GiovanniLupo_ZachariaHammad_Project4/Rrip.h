@@ -0,0 +1,72 @@
+#ifndef __RRIP_H__
+#define __RRIP_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Dynamic RRIP with set dueling (Jaleel et al., ISCA 2010) */
+typedef struct Drrip
+{
+    unsigned leader_stride; // One SRRIP and one BRRIP leader set every leader_stride sets
+    unsigned psel; // Policy selector, >= psel_max / 2 favours BRRIP
+    unsigned psel_max;
+    uint64_t brrip_fills; // Every brrip_epsilon-th BRRIP fill is inserted at max_rrpv - 1
+} Drrip;
+
+/* SHiP++ (Young et al., CRC-2 2017) */
+typedef struct Ship_PP
+{
+    uint8_t *shct; // Signature history counter table
+    unsigned table_size;
+    uint8_t max_counter;
+} Ship_PP;
+
+/* One sampled set as seen by OPTgen */
+typedef struct OPTgen_Set
+{
+    uint8_t *occupancy; // Liveness intervals overlapping each time quantum
+    uint64_t time; // Accesses to this set so far
+
+    uint64_t *tags; // Sampler entries: block addresses seen in the history window
+    uint64_t *last_time;
+    uint32_t *last_sig; // Signature that last touched the entry
+    unsigned num_entries;
+} OPTgen_Set;
+
+/* Hawkeye (Jain and Lin, ISCA 2016) */
+typedef struct Hawkeye
+{
+    unsigned sample_shift; // One out of (1 << sample_shift) sets is sampled
+    unsigned num_sampled_sets;
+    unsigned num_ways;
+    unsigned history; // OPTgen window, in accesses to a set
+
+    OPTgen_Set *sampled_sets;
+
+    uint8_t *predictor; // Cache-friendly counters indexed by signature
+    unsigned table_size;
+    uint8_t max_counter;
+
+    uint64_t opt_hits;
+    uint64_t opt_accesses;
+} Hawkeye;
+
+// Function Definitions
+Drrip *initDrrip(unsigned num_sets);
+bool isSrripLeader(Drrip *drrip, uint64_t set_idx);
+bool isBrripLeader(Drrip *drrip, uint64_t set_idx);
+
+Ship_PP *initShipPP();
+uint32_t shipPPSignature(Ship_PP *ship_pp, uint64_t PC, int core_id);
+void trainShipPP(Ship_PP *ship_pp, uint32_t signature, bool reused);
+
+Hawkeye *initHawkeye(unsigned num_sets, unsigned num_ways);
+uint32_t hawkeyeSignature(Hawkeye *hawkeye, uint64_t PC, int core_id);
+bool hawkeyeFriendly(Hawkeye *hawkeye, uint32_t signature);
+void trainHawkeye(Hawkeye *hawkeye, uint32_t signature, bool opt_hit);
+void hawkeyeAccess(Hawkeye *hawkeye, uint64_t set_idx, uint64_t blk_addr, uint32_t signature);
+
+#endif /* __RRIP_H__ */
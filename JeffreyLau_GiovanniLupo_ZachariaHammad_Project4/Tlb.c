@@ -0,0 +1,206 @@
+#include "Tlb.h"
+
+extern const uint64_t hit_latency;
+extern const uint64_t miss_latency;
+extern const unsigned num_cores;
+
+/* Constants */
+// PAGE_4K, PAGE_2M or PAGE_1G; huge pages cut TLB misses and page-walk depth
+const Page_Size page_backing = PAGE_4K;
+
+const unsigned l1_tlb_sets[NUM_PAGE_SIZES] = {16, 8, 1}; // 64 x 4K, 32 x 2M, 4 x 1G entries
+const unsigned l1_tlb_ways[NUM_PAGE_SIZES] = {4, 4, 4};
+const unsigned l2_tlb_sets = 128; // 1536 entries shared by all page sizes
+const unsigned l2_tlb_ways = 12;
+const unsigned pwc_entries = 16; // Fully associative, per level
+
+const uint64_t l2_tlb_latency = 7; // Cycles on an L1 TLB miss
+
+const unsigned page_shifts[NUM_PAGE_SIZES] = {12, 21, 30};
+
+Tlb_Array *initTlbArray(unsigned num_sets, unsigned num_ways)
+{
+    Tlb_Array *array = (Tlb_Array *)calloc(1, sizeof(Tlb_Array));
+    array->num_sets = num_sets;
+    array->num_ways = num_ways;
+    array->entries = (Tlb_Entry *)calloc(num_sets * num_ways, sizeof(Tlb_Entry));
+    return array;
+}
+
+bool tlbLookup(Tlb_Array *array, uint64_t va, unsigned page_shift)
+{
+    uint64_t vpn = va >> page_shift;
+    Tlb_Entry *set = &array->entries[(vpn % array->num_sets) * array->num_ways];
+
+    array->time++;
+    for (unsigned i = 0; i < array->num_ways; i++)
+    {
+        if (set[i].valid && set[i].vpn == vpn && set[i].page_shift == page_shift)
+        {
+            set[i].when_touched = array->time;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void tlbInsert(Tlb_Array *array, uint64_t va, unsigned page_shift)
+{
+    uint64_t vpn = va >> page_shift;
+    Tlb_Entry *set = &array->entries[(vpn % array->num_sets) * array->num_ways];
+
+    // Invalid way first, then LRU
+    Tlb_Entry *victim = &set[0];
+    for (unsigned i = 0; i < array->num_ways; i++)
+    {
+        if (!set[i].valid)
+        {
+            victim = &set[i];
+            break;
+        }
+
+        if (set[i].when_touched < victim->when_touched)
+        {
+            victim = &set[i];
+        }
+    }
+
+    victim->vpn = vpn;
+    victim->page_shift = page_shift;
+    victim->valid = true;
+    victim->when_touched = ++array->time;
+}
+
+Tlb *initTlb()
+{
+    Tlb *tlb = (Tlb *)calloc(1, sizeof(Tlb));
+    tlb->page_size = page_backing;
+    tlb->num_cores = num_cores;
+    tlb->cores = (Core_Tlb *)calloc(num_cores, sizeof(Core_Tlb));
+
+    for (unsigned c = 0; c < num_cores; c++)
+    {
+        Core_Tlb *core = &tlb->cores[c];
+        for (unsigned i = 0; i < NUM_PAGE_SIZES; i++)
+        {
+            core->l1[i] = initTlbArray(l1_tlb_sets[i], l1_tlb_ways[i]);
+        }
+        core->l2 = initTlbArray(l2_tlb_sets, l2_tlb_ways);
+
+        for (unsigned level = 2; level <= PAGE_TABLE_LEVELS; level++)
+        {
+            core->pwc[level] = initTlbArray(1, pwc_entries);
+        }
+    }
+
+    return tlb;
+}
+
+// Each level-L entry maps 2^shift bytes: 4KB at the PT, 2MB at the PD, 1GB at the PDPT, 512GB at the PML4
+unsigned levelShift(unsigned level)
+{
+    return 12 + 9 * (level - 1);
+}
+
+// Walk the page table for va, loading every entry the page-walk cache does not supply through the cache
+uint64_t pageWalk(Tlb *tlb, Core_Tlb *core, Cache *cache, Request *req, uint64_t access_time)
+{
+    unsigned leaf = tlb->page_size + 1; // PT for 4K pages, PD for 2M, PDPT for 1G
+    uint64_t va = req->load_or_store_addr;
+    uint64_t latency = 0;
+
+    // Step one: the lowest cached non-leaf level tells where the walk starts
+    unsigned start = PAGE_TABLE_LEVELS;
+    for (unsigned level = leaf + 1; level <= PAGE_TABLE_LEVELS; level++)
+    {
+        if (tlbLookup(core->pwc[level], va, levelShift(level)))
+        {
+            tlb->pwc_hits[level]++;
+            start = level - 1;
+            break;
+        }
+        tlb->pwc_misses[level]++;
+    }
+
+    // Step two: load the remaining entries, each level living in its own region of memory
+    for (unsigned level = start; level >= leaf; level--)
+    {
+        Request walk_req = *req;
+        walk_req.req_type = LOAD;
+        walk_req.load_or_store_addr = ((uint64_t)level << 56) + (va >> levelShift(level)) * 8;
+        walk_req.next_use = UINT64_MAX;
+        walk_req.prefetcher_id = -1;
+        walk_req.has_data = false;
+
+        tlb->walk_refs++;
+        if (!inSampledSet(cache, walk_req.load_or_store_addr))
+        {
+            latency += miss_latency; // Not modeled, assume the worst
+        }
+        else if (accessBlock(cache, &walk_req, access_time))
+        {
+            tlb->walk_ref_hits++;
+            latency += hit_latency;
+        }
+        else
+        {
+            latency += miss_latency;
+        }
+
+        if (level > leaf)
+        {
+            tlbInsert(core->pwc[level], va, levelShift(level));
+        }
+    }
+
+    tlb->walks++;
+    return latency;
+}
+
+// Translate req's virtual address, returning the cycles spent on the translation
+uint64_t translate(Tlb *tlb, Cache *cache, Request *req, uint64_t access_time)
+{
+    assert(req->core_id >= 0 && (unsigned)req->core_id < tlb->num_cores);
+    Core_Tlb *core = &tlb->cores[req->core_id];
+
+    unsigned page_shift = page_shifts[tlb->page_size];
+    uint64_t va = req->load_or_store_addr;
+    uint64_t latency = 0;
+
+    if (tlbLookup(core->l1[tlb->page_size], va, page_shift))
+    {
+        tlb->l1_hits++;
+    }
+    else
+    {
+        tlb->l1_misses++;
+        latency += l2_tlb_latency;
+
+        if (tlbLookup(core->l2, va, page_shift))
+        {
+            tlb->l2_hits++;
+        }
+        else
+        {
+            tlb->l2_misses++;
+            latency += pageWalk(tlb, core, cache, req, access_time);
+            tlbInsert(core->l2, va, page_shift);
+        }
+        tlbInsert(core->l1[tlb->page_size], va, page_shift);
+    }
+
+    tlb->translation_cycles += latency;
+    return latency;
+}
+
+const char *pageSizeName(Page_Size page_size)
+{
+    switch (page_size)
+    {
+        case PAGE_4K: return "4KB";
+        case PAGE_2M: return "2MB";
+        case PAGE_1G: return "1GB";
+        default: return "?";
+    }
+}
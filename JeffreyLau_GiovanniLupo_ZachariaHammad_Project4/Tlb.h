@@ -0,0 +1,69 @@
+#ifndef __TLB_H__
+#define __TLB_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Cache.h"
+
+// Uncomment to translate every address through L1/L2 TLBs, walking the page table through the cache
+//#define TLB_MODEL
+
+typedef enum Page_Size{PAGE_4K, PAGE_2M, PAGE_1G, NUM_PAGE_SIZES}Page_Size;
+
+#define PAGE_TABLE_LEVELS 4 // x86-64 style radix tree: PML4, PDPT, PD, PT
+
+/* Set-associative LRU array of translations */
+typedef struct Tlb_Entry
+{
+    uint64_t vpn; // Virtual address >> page_shift
+    unsigned page_shift;
+    bool valid;
+    uint64_t when_touched;
+} Tlb_Entry;
+
+typedef struct Tlb_Array
+{
+    Tlb_Entry *entries;
+    unsigned num_sets;
+    unsigned num_ways;
+    uint64_t time;
+} Tlb_Array;
+
+/* Translation structures private to a core */
+typedef struct Core_Tlb
+{
+    Tlb_Array *l1[NUM_PAGE_SIZES]; // Split L1 TLB, one array per page size
+    Tlb_Array *l2; // Unified L2 TLB
+    Tlb_Array *pwc[PAGE_TABLE_LEVELS + 1]; // Page-walk cache per non-leaf level (2..4)
+} Core_Tlb;
+
+typedef struct Tlb
+{
+    Page_Size page_size; // How the whole trace is backed
+
+    unsigned num_cores;
+    Core_Tlb *cores;
+
+    uint64_t l1_hits;
+    uint64_t l1_misses;
+    uint64_t l2_hits;
+    uint64_t l2_misses;
+    uint64_t pwc_hits[PAGE_TABLE_LEVELS + 1];
+    uint64_t pwc_misses[PAGE_TABLE_LEVELS + 1];
+
+    uint64_t walks;
+    uint64_t walk_refs; // Page-table entries loaded through the cache
+    uint64_t walk_ref_hits;
+    uint64_t translation_cycles;
+} Tlb;
+
+// Function Definitions
+Tlb *initTlb();
+uint64_t translate(Tlb *tlb, Cache *cache, Request *req, uint64_t access_time);
+const char *pageSizeName(Page_Size page_size);
+
+#endif /* __TLB_H__ */
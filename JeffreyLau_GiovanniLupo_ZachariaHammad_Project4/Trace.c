@@ -40,11 +40,28 @@ bool getRequest(TraceParser *mem_trace)
         {
             req_type = STORE;
         }
+        else if (strcmp(ptr, "W") == 0)
+        {
+            req_type = WRITEBACK;
+        }
 
         mem_trace->cur_req->req_type = req_type;
         mem_trace->cur_req->load_or_store_addr = load_or_store_addr;
         mem_trace->cur_req->PC = PC;
         mem_trace->cur_req->core_id = core_id;
+        mem_trace->cur_req->next_use = UINT64_MAX;
+        mem_trace->cur_req->prefetcher_id = -1;
+
+        // Optional block contents, as REQUEST_DATA_SIZE bytes in hex
+        ptr = strtok(NULL, delim);
+        mem_trace->cur_req->has_data = ptr != NULL && strlen(ptr) == 2 * REQUEST_DATA_SIZE;
+        if (mem_trace->cur_req->has_data)
+        {
+            for (int i = 0; i < REQUEST_DATA_SIZE; i++)
+            {
+                mem_trace->cur_req->data[i] = (uint8_t)((hexDigit(ptr[2 * i]) << 4) | hexDigit(ptr[2 * i + 1]));
+            }
+        }
 
         free(line);
         line = NULL;
@@ -89,6 +106,15 @@ uint64_t convToUint64(char *ptr)
     return ret;
 }
 
+unsigned hexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    return (c | 0x20) - 'a' + 10;
+}
+
 // print instruction (debugging)
 void printMemRequest(Request *req)
 {
@@ -106,4 +132,8 @@ void printMemRequest(Request *req)
     {
         printf("S\n");
     }
+    else if (req->req_type == WRITEBACK)
+    {
+        printf("W\n");
+    }
 }
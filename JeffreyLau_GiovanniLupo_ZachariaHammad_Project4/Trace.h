@@ -19,6 +19,7 @@ typedef struct TraceParser
 TraceParser *initTraceParser(const char * mem_file);
 bool getRequest(TraceParser *mem_trace);
 uint64_t convToUint64(char *ptr);
+unsigned hexDigit(char c);
 void printMemRequest(Request *req);
 
 #endif
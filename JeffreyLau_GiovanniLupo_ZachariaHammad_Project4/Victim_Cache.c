@@ -0,0 +1,314 @@
+#include "Victim_Cache.h"
+
+/* Constants */
+const unsigned victim_cache_entries = 16;
+
+unsigned hashBlock(uint64_t blk_addr)
+{
+    blk_addr ^= blk_addr >> 29;
+    blk_addr *= 0xbf58476d1ce4e5b9ULL;
+    blk_addr ^= blk_addr >> 32;
+    return (unsigned)blk_addr;
+}
+
+/* LRU stack */
+LRU_Stack *initLRUStack(unsigned capacity)
+{
+    LRU_Stack *stack = (LRU_Stack *)malloc(sizeof(LRU_Stack));
+    stack->capacity = capacity;
+    stack->size = 0;
+    stack->mru = -1;
+    stack->lru = -1;
+
+    stack->nodes = (LRU_Node *)malloc(capacity * sizeof(LRU_Node));
+    for (unsigned i = 0; i < capacity; i++)
+    {
+        stack->nodes[i].next = i + 1 < capacity ? (int)(i + 1) : -1;
+    }
+    stack->free_list = 0;
+
+    // Keep the index at most half full
+    unsigned index_size = 1;
+    while (index_size < 2 * capacity)
+    {
+        index_size <<= 1;
+    }
+    stack->index_mask = index_size - 1;
+    stack->index = (int *)malloc(index_size * sizeof(int));
+    for (unsigned i = 0; i < index_size; i++)
+    {
+        stack->index[i] = -1;
+    }
+
+    return stack;
+}
+
+// Index slot holding blk_addr, or the empty slot where it would go
+unsigned indexSlot(LRU_Stack *stack, uint64_t blk_addr)
+{
+    unsigned slot = hashBlock(blk_addr) & stack->index_mask;
+    while (stack->index[slot] >= 0 && stack->nodes[stack->index[slot]].blk_addr != blk_addr)
+    {
+        slot = (slot + 1) & stack->index_mask;
+    }
+    return slot;
+}
+
+// Backward-shift deletion keeps probe sequences intact without tombstones
+void indexErase(LRU_Stack *stack, unsigned slot)
+{
+    unsigned hole = slot;
+    unsigned next = slot;
+
+    while (true)
+    {
+        next = (next + 1) & stack->index_mask;
+        if (stack->index[next] < 0)
+        {
+            break;
+        }
+
+        unsigned home = hashBlock(stack->nodes[stack->index[next]].blk_addr) & stack->index_mask;
+        bool between = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (between)
+        {
+            continue; // Still reachable from its home slot
+        }
+
+        stack->index[hole] = stack->index[next];
+        hole = next;
+    }
+
+    stack->index[hole] = -1;
+}
+
+int lruStackFind(LRU_Stack *stack, uint64_t blk_addr)
+{
+    return stack->index[indexSlot(stack, blk_addr)];
+}
+
+void unlinkNode(LRU_Stack *stack, int node)
+{
+    LRU_Node *n = &stack->nodes[node];
+
+    if (n->prev >= 0)
+    {
+        stack->nodes[n->prev].next = n->next;
+    }
+    else
+    {
+        stack->mru = n->next;
+    }
+
+    if (n->next >= 0)
+    {
+        stack->nodes[n->next].prev = n->prev;
+    }
+    else
+    {
+        stack->lru = n->prev;
+    }
+}
+
+void pushMRU(LRU_Stack *stack, int node)
+{
+    LRU_Node *n = &stack->nodes[node];
+    n->prev = -1;
+    n->next = stack->mru;
+
+    if (stack->mru >= 0)
+    {
+        stack->nodes[stack->mru].prev = node;
+    }
+    else
+    {
+        stack->lru = node;
+    }
+    stack->mru = node;
+}
+
+void lruStackTouch(LRU_Stack *stack, int node)
+{
+    if (stack->mru != node)
+    {
+        unlinkNode(stack, node);
+        pushMRU(stack, node);
+    }
+}
+
+void lruStackRemove(LRU_Stack *stack, int node)
+{
+    indexErase(stack, indexSlot(stack, stack->nodes[node].blk_addr));
+    unlinkNode(stack, node);
+
+    stack->nodes[node].next = stack->free_list;
+    stack->free_list = node;
+    stack->size--;
+}
+
+// Insert blk_addr at the MRU position, returning whether the LRU entry had to go
+bool lruStackInsert(LRU_Stack *stack, uint64_t blk_addr, bool dirty, LRU_Node *evicted)
+{
+    bool eviction = false;
+
+    if (stack->size == stack->capacity)
+    {
+        *evicted = stack->nodes[stack->lru];
+        lruStackRemove(stack, stack->lru);
+        eviction = true;
+    }
+
+    int node = stack->free_list;
+    stack->free_list = stack->nodes[node].next;
+    stack->size++;
+
+    stack->nodes[node].blk_addr = blk_addr;
+    stack->nodes[node].dirty = dirty;
+    stack->index[indexSlot(stack, blk_addr)] = node;
+    pushMRU(stack, node);
+
+    return eviction;
+}
+
+/* Victim cache */
+Victim_Cache *initVictimCache()
+{
+    Victim_Cache *vc = (Victim_Cache *)calloc(1, sizeof(Victim_Cache));
+    vc->entries = initLRUStack(victim_cache_entries);
+    return vc;
+}
+
+// A block has been evicted from the main cache
+void victimCacheFill(Victim_Cache *vc, uint64_t blk_addr, bool dirty)
+{
+    LRU_Node evicted;
+
+    vc->fills++;
+    if (lruStackInsert(vc->entries, blk_addr, dirty, &evicted) && evicted.dirty)
+    {
+        vc->wb_pending = true;
+        vc->wb_addr = evicted.blk_addr;
+    }
+}
+
+// Look up a main-cache miss; a hit moves the block back into the main cache
+bool victimCacheLookup(Victim_Cache *vc, uint64_t blk_addr, bool *dirty)
+{
+    int node = lruStackFind(vc->entries, blk_addr);
+    if (node < 0)
+    {
+        return false;
+    }
+
+    *dirty = vc->entries->nodes[node].dirty;
+    lruStackRemove(vc->entries, node);
+    vc->hits++;
+
+    return true;
+}
+
+/* Set of referenced blocks */
+Block_Set *initBlockSet()
+{
+    Block_Set *set = (Block_Set *)malloc(sizeof(Block_Set));
+    set->capacity = 1024;
+    set->size = 0;
+    set->blk_addrs = (uint64_t *)malloc(set->capacity * sizeof(uint64_t));
+    for (uint64_t i = 0; i < set->capacity; i++)
+    {
+        set->blk_addrs[i] = UINT64_MAX;
+    }
+    return set;
+}
+
+// Returns true if blk_addr was not in the set yet
+bool blockSetInsert(Block_Set *set, uint64_t blk_addr);
+
+void growBlockSet(Block_Set *set)
+{
+    uint64_t *old_addrs = set->blk_addrs;
+    uint64_t old_capacity = set->capacity;
+
+    set->capacity *= 2;
+    set->size = 0;
+    set->blk_addrs = (uint64_t *)malloc(set->capacity * sizeof(uint64_t));
+    for (uint64_t i = 0; i < set->capacity; i++)
+    {
+        set->blk_addrs[i] = UINT64_MAX;
+    }
+
+    for (uint64_t i = 0; i < old_capacity; i++)
+    {
+        if (old_addrs[i] != UINT64_MAX)
+        {
+            blockSetInsert(set, old_addrs[i]);
+        }
+    }
+
+    free(old_addrs);
+}
+
+bool blockSetInsert(Block_Set *set, uint64_t blk_addr)
+{
+    uint64_t mask = set->capacity - 1;
+    uint64_t slot = hashBlock(blk_addr) & mask;
+
+    while (set->blk_addrs[slot] != UINT64_MAX)
+    {
+        if (set->blk_addrs[slot] == blk_addr)
+        {
+            return false;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    set->blk_addrs[slot] = blk_addr;
+    if (2 * ++set->size > set->capacity)
+    {
+        growBlockSet(set);
+    }
+
+    return true;
+}
+
+/* 3C miss classifier */
+Miss_Classifier *initMissClassifier(unsigned num_blocks)
+{
+    Miss_Classifier *classifier = (Miss_Classifier *)calloc(1, sizeof(Miss_Classifier));
+    classifier->shadow = initLRUStack(num_blocks);
+    classifier->seen = initBlockSet();
+    return classifier;
+}
+
+// Classify a demand access to the real cache against a fully-associative LRU cache of the same size
+void classifyAccess(Miss_Classifier *classifier, uint64_t blk_addr, bool hit)
+{
+    bool first_reference = blockSetInsert(classifier->seen, blk_addr);
+    int node = lruStackFind(classifier->shadow, blk_addr);
+
+    if (!hit)
+    {
+        if (first_reference)
+        {
+            classifier->compulsory++;
+        }
+        else if (node < 0)
+        {
+            classifier->capacity++; // Even full associativity would have missed
+        }
+        else
+        {
+            classifier->conflict++;
+        }
+    }
+
+    if (node >= 0)
+    {
+        lruStackTouch(classifier->shadow, node);
+    }
+    else
+    {
+        LRU_Node evicted;
+        lruStackInsert(classifier->shadow, blk_addr, false, &evicted);
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef __VICTIM_CACHE_H__
+#define __VICTIM_CACHE_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Uncomment to put a small fully-associative victim cache behind the main cache
+//#define VICTIM_CACHE
+
+// Uncomment to classify every miss as compulsory, capacity or conflict
+//#define MISS_CLASSIFICATION
+
+/* Fully-associative LRU stack: hash index + doubly linked list, O(1) per operation */
+typedef struct LRU_Node
+{
+    uint64_t blk_addr;
+    bool dirty;
+    int prev; // Towards the MRU end
+    int next; // Towards the LRU end, also links the free list
+} LRU_Node;
+
+typedef struct LRU_Stack
+{
+    LRU_Node *nodes;
+    unsigned capacity;
+    unsigned size;
+
+    int mru;
+    int lru;
+    int free_list;
+
+    int *index; // Open-addressing map from block address to node, -1 marks an empty slot
+    unsigned index_mask;
+} LRU_Stack;
+
+/* Victim cache */
+typedef struct Victim_Cache
+{
+    LRU_Stack *entries;
+
+    uint64_t hits; // Main-cache misses served by the victim cache
+    uint64_t fills; // Blocks evicted from the main cache
+
+    // A dirty block pushed out by the last fill, to be written back instead of the main victim
+    bool wb_pending;
+    uint64_t wb_addr;
+} Victim_Cache;
+
+/* Set of every block ever referenced */
+typedef struct Block_Set
+{
+    uint64_t *blk_addrs; // UINT64_MAX marks an empty slot
+    uint64_t capacity;
+    uint64_t size;
+} Block_Set;
+
+/* 3C miss classifier */
+typedef struct Miss_Classifier
+{
+    LRU_Stack *shadow; // Fully-associative LRU cache with as many blocks as the real one
+    Block_Set *seen;
+
+    uint64_t compulsory;
+    uint64_t capacity;
+    uint64_t conflict;
+} Miss_Classifier;
+
+// Function Definitions
+LRU_Stack *initLRUStack(unsigned capacity);
+int lruStackFind(LRU_Stack *stack, uint64_t blk_addr);
+void lruStackTouch(LRU_Stack *stack, int node);
+bool lruStackInsert(LRU_Stack *stack, uint64_t blk_addr, bool dirty, LRU_Node *evicted);
+void lruStackRemove(LRU_Stack *stack, int node);
+
+Victim_Cache *initVictimCache();
+void victimCacheFill(Victim_Cache *vc, uint64_t blk_addr, bool dirty);
+bool victimCacheLookup(Victim_Cache *vc, uint64_t blk_addr, bool *dirty);
+
+Miss_Classifier *initMissClassifier(unsigned num_blocks);
+void classifyAccess(Miss_Classifier *classifier, uint64_t blk_addr, bool hit);
+
+#endif /* __VICTIM_CACHE_H__ */
@@ -0,0 +1,93 @@
+#include "Way_Predictor.h"
+
+/* Constants */
+// MRU_WAY_PREDICTOR or PC_WAY_PREDICTOR
+const Way_Predictor_Type way_predictor_type = MRU_WAY_PREDICTOR;
+const unsigned pc_way_table_size = 1024;
+
+// Per-way access energy and array latencies
+const double tag_read_energy = 2.0; // pJ per way
+const double data_read_energy = 20.0; // pJ per way, a full 64B block
+const uint64_t tag_cycles = 1;
+const uint64_t data_cycles = 2;
+const uint64_t way_select_cycles = 1; // Multiplexing the data of the matching way
+
+Way_Predictor *initWayPredictor(unsigned num_sets, unsigned num_ways)
+{
+    assert(num_ways <= 256);
+
+    Way_Predictor *wp = (Way_Predictor *)calloc(1, sizeof(Way_Predictor));
+    wp->type = way_predictor_type;
+    wp->num_ways = num_ways;
+    wp->table_size = wp->type == MRU_WAY_PREDICTOR ? num_sets : pc_way_table_size;
+    wp->table = (uint8_t *)calloc(wp->table_size, sizeof(uint8_t));
+    return wp;
+}
+
+unsigned wayPredictorIndex(Way_Predictor *wp, uint64_t set_idx, uint64_t PC)
+{
+    if (wp->type == MRU_WAY_PREDICTOR)
+    {
+        return set_idx;
+    }
+    return (unsigned)((PC ^ (PC >> 10) ^ set_idx) % wp->table_size);
+}
+
+// Account one lookup under every scheme; hit_way is -1 on a miss
+void wayLookup(Way_Predictor *wp, uint64_t set_idx, uint64_t PC, int hit_way)
+{
+    unsigned predicted = wp->table[wayPredictorIndex(wp, set_idx, PC)];
+    bool hit = hit_way >= 0;
+    double ways = (double)wp->num_ways;
+
+    wp->lookups++;
+    wp->hits += hit;
+
+    // Parallel: every tag and every data way at once
+    wp->energy[PARALLEL_LOOKUP] += ways * (tag_read_energy + data_read_energy);
+    wp->latency[PARALLEL_LOOKUP] += (tag_cycles > data_cycles ? tag_cycles : data_cycles) + way_select_cycles;
+
+    // Serial: every tag, then only the matching data way
+    wp->energy[SERIAL_LOOKUP] += ways * tag_read_energy + (hit ? data_read_energy : 0);
+    wp->latency[SERIAL_LOOKUP] += tag_cycles + (hit ? data_cycles : 0);
+
+    // Predicted: one way first, the remaining ways in parallel when that was wrong
+    wp->energy[PREDICTED_LOOKUP] += tag_read_energy + data_read_energy;
+    wp->latency[PREDICTED_LOOKUP] += tag_cycles > data_cycles ? tag_cycles : data_cycles;
+    if (hit && (unsigned)hit_way == predicted)
+    {
+        wp->first_probe_hits++;
+    }
+    else
+    {
+        wp->energy[PREDICTED_LOOKUP] += (ways - 1) * (tag_read_energy + data_read_energy);
+        wp->latency[PREDICTED_LOOKUP] += (tag_cycles > data_cycles ? tag_cycles : data_cycles) + way_select_cycles;
+    }
+}
+
+// Point the predictor at the way the block now lives in
+void trainWayPredictor(Way_Predictor *wp, uint64_t set_idx, uint64_t PC, unsigned way)
+{
+    wp->table[wayPredictorIndex(wp, set_idx, PC)] = (uint8_t)way;
+}
+
+const char *lookupSchemeName(Lookup_Scheme scheme)
+{
+    switch (scheme)
+    {
+        case PARALLEL_LOOKUP: return "Parallel";
+        case SERIAL_LOOKUP: return "Serial";
+        case PREDICTED_LOOKUP: return "Way-predicted";
+        default: return "?";
+    }
+}
+
+const char *wayPredictorName(Way_Predictor_Type type)
+{
+    switch (type)
+    {
+        case MRU_WAY_PREDICTOR: return "MRU";
+        case PC_WAY_PREDICTOR: return "PC";
+        default: return "?";
+    }
+}
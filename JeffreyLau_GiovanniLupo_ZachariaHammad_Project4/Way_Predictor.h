@@ -0,0 +1,40 @@
+#ifndef __WAY_PREDICTOR_H__
+#define __WAY_PREDICTOR_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Uncomment to predict the way before the lookup and compare lookup energy and latency
+//#define WAY_PREDICTION
+
+typedef enum Way_Predictor_Type{MRU_WAY_PREDICTOR, PC_WAY_PREDICTOR}Way_Predictor_Type;
+
+typedef enum Lookup_Scheme{PARALLEL_LOOKUP, SERIAL_LOOKUP, PREDICTED_LOOKUP, NUM_LOOKUP_SCHEMES}Lookup_Scheme;
+
+typedef struct Way_Predictor
+{
+    Way_Predictor_Type type;
+    uint8_t *table; // Predicted way, per set (MRU) or per PC hash (PC)
+    unsigned table_size;
+    unsigned num_ways;
+
+    uint64_t lookups;
+    uint64_t hits; // Lookups that hit in the cache
+    uint64_t first_probe_hits; // ... in the predicted way
+
+    // Totals for every lookup scheme, as if the cache had been built that way
+    double energy[NUM_LOOKUP_SCHEMES]; // pJ
+    uint64_t latency[NUM_LOOKUP_SCHEMES]; // Cycles
+} Way_Predictor;
+
+// Function Definitions
+Way_Predictor *initWayPredictor(unsigned num_sets, unsigned num_ways);
+void wayLookup(Way_Predictor *wp, uint64_t set_idx, uint64_t PC, int hit_way);
+void trainWayPredictor(Way_Predictor *wp, uint64_t set_idx, uint64_t PC, unsigned way);
+const char *lookupSchemeName(Lookup_Scheme scheme);
+const char *wayPredictorName(Way_Predictor_Type type);
+
+#endif /* __WAY_PREDICTOR_H__ */
@@ -0,0 +1,77 @@
+#include "Wb_Buffer.h"
+
+/* Constants */
+const unsigned wb_buffer_entries = 8;
+const uint64_t wb_drain_cycles = 8; // One 64B write every 8 requests saturates the next level
+
+Wb_Buffer *initWbBuffer()
+{
+    Wb_Buffer *buffer = (Wb_Buffer *)calloc(1, sizeof(Wb_Buffer));
+    buffer->num_entries = wb_buffer_entries;
+    buffer->blk_addrs = (uint64_t *)malloc(wb_buffer_entries * sizeof(uint64_t));
+    buffer->drain_cycles = wb_drain_cycles;
+    return buffer;
+}
+
+void drainHead(Wb_Buffer *buffer)
+{
+    buffer->head = (buffer->head + 1) % buffer->num_entries;
+    buffer->occupancy--;
+    buffer->drained++;
+}
+
+// Retire every write the next level has finished by access_time
+void wbBufferTick(Wb_Buffer *buffer, uint64_t access_time)
+{
+    while (buffer->occupancy > 0 && buffer->next_drain <= access_time)
+    {
+        drainHead(buffer);
+        if (buffer->occupancy > 0)
+        {
+            buffer->next_drain += buffer->drain_cycles;
+        }
+    }
+
+    buffer->occupancy_sum += buffer->occupancy;
+}
+
+bool wbBufferContains(Wb_Buffer *buffer, uint64_t blk_addr)
+{
+    for (unsigned i = 0; i < buffer->occupancy; i++)
+    {
+        if (buffer->blk_addrs[(buffer->head + i) % buffer->num_entries] == blk_addr)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void wbBufferInsert(Wb_Buffer *buffer, uint64_t blk_addr, uint64_t access_time)
+{
+    buffer->inserted++;
+
+    // Coalesce with a write of the same block that has not left yet
+    if (wbBufferContains(buffer, blk_addr))
+    {
+        buffer->coalesced++;
+        return;
+    }
+
+    if (buffer->occupancy == buffer->num_entries)
+    {
+        // Full: the cache waits for the head to drain
+        buffer->full_stalls++;
+        drainHead(buffer);
+        buffer->next_drain = (buffer->next_drain > access_time ? buffer->next_drain : access_time) +
+                             buffer->drain_cycles;
+    }
+
+    if (buffer->occupancy == 0)
+    {
+        buffer->next_drain = access_time + buffer->drain_cycles;
+    }
+
+    buffer->blk_addrs[(buffer->head + buffer->occupancy) % buffer->num_entries] = blk_addr;
+    buffer->occupancy++;
+}
@@ -0,0 +1,41 @@
+#ifndef __WB_BUFFER_H__
+#define __WB_BUFFER_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Uncomment to send dirty evictions through a bounded write-back buffer
+//#define WRITE_BACK_BUFFER
+// Write dirty LRU blocks back early while the buffer is idle (requires WRITE_BACK_BUFFER)
+//#define EAGER_WRITE_BACK
+
+/* FIFO of blocks waiting to be written to the next level */
+typedef struct Wb_Buffer
+{
+    uint64_t *blk_addrs; // Circular, oldest at head
+    unsigned num_entries;
+    unsigned head;
+    unsigned occupancy;
+
+    uint64_t drain_cycles; // Cycles the next level needs per write
+    uint64_t next_drain; // When the head entry finishes draining
+
+    uint64_t inserted; // Write-backs from the cache
+    uint64_t coalesced; // ... that merged with a block already waiting
+    uint64_t eager; // Dirty blocks cleaned early
+    uint64_t drained; // Writes that reached the next level
+    uint64_t full_stalls; // Inserts that had to wait for a drain
+    uint64_t read_hits; // Misses served from a waiting block
+    uint64_t occupancy_sum;
+} Wb_Buffer;
+
+// Function Definitions
+Wb_Buffer *initWbBuffer();
+void wbBufferTick(Wb_Buffer *buffer, uint64_t access_time);
+void wbBufferInsert(Wb_Buffer *buffer, uint64_t blk_addr, uint64_t access_time);
+bool wbBufferContains(Wb_Buffer *buffer, uint64_t blk_addr);
+
+#endif /* __WB_BUFFER_H__ */